@@ -0,0 +1,188 @@
+/*
+
+    Allocation counting for the optional telemetry build
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <cstdlib>
+#include <new>
+
+#include "allocstats.h"
+
+#ifdef GGVTOGPX_ALLOC_STATS
+
+// Plain struct so that the thread local needs no constructor call
+// and no allocation when it is first touched from inside malloc.
+static thread_local AllocCount alloc_count;
+
+static inline void
+alloc_stats_count(std::size_t size)
+{
+  alloc_count.count++;
+  alloc_count.bytes += size;
+}
+
+#ifdef __GLIBC__
+// Qt containers (QString, QByteArray, ...) allocate with malloc and
+// not with operator new. On glibc the malloc family can be
+// interposed by the executable and forwarded to the __libc_
+// entry points.
+extern "C" {
+  void* __libc_malloc(std::size_t size);
+  void* __libc_calloc(std::size_t nmemb, std::size_t size);
+  void* __libc_realloc(void* ptr, std::size_t size);
+  void __libc_free(void* ptr);
+
+  void* malloc(std::size_t size)
+  {
+    alloc_stats_count(size);
+    return __libc_malloc(size);
+  }
+
+  void* calloc(std::size_t nmemb, std::size_t size)
+  {
+    alloc_stats_count(nmemb * size);
+    return __libc_calloc(nmemb, size);
+  }
+
+  void* realloc(void* ptr, std::size_t size)
+  {
+    alloc_stats_count(size);
+    return __libc_realloc(ptr, size);
+  }
+
+  void free(void* ptr)
+  {
+    __libc_free(ptr);
+  }
+}
+
+static inline void*
+alloc_stats_raw_malloc(std::size_t size)
+{
+  return __libc_malloc(size);
+}
+#else
+static inline void*
+alloc_stats_raw_malloc(std::size_t size)
+{
+  return std::malloc(size);
+}
+#endif
+
+void*
+operator new(std::size_t size)
+{
+  alloc_stats_count(size);
+  void* ptr = alloc_stats_raw_malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void*
+operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  alloc_stats_count(size);
+  return alloc_stats_raw_malloc(size ? size : 1);
+}
+
+void*
+operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+  return operator new(size, tag);
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, [[maybe_unused]] std::size_t size) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete[](void* ptr, [[maybe_unused]] std::size_t size) noexcept
+{
+  std::free(ptr);
+}
+
+bool
+AllocStats::isAvailable()
+{
+  return true;
+}
+
+AllocCount
+AllocStats::current()
+{
+  return alloc_count;
+}
+
+void
+AllocStats::add(const AllocCount& count)
+{
+  alloc_count.count += count.count;
+  alloc_count.bytes += count.bytes;
+}
+
+#else
+
+bool
+AllocStats::isAvailable()
+{
+  return false;
+}
+
+AllocCount
+AllocStats::current()
+{
+  return {0, 0};
+}
+
+void
+AllocStats::add([[maybe_unused]] const AllocCount& count)
+{
+}
+
+#endif
+
+AllocCount
+AllocCounter::delta() const
+{
+  AllocCount now = AllocStats::current();
+  return {now.count - start.count, now.bytes - start.bytes};
+}
@@ -0,0 +1,56 @@
+/*
+
+    Allocation counting for the optional telemetry build
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef ALLOCSTATS_H_INCLUDED_
+#define ALLOCSTATS_H_INCLUDED_
+
+#include <QtGlobal>
+
+struct AllocCount {
+  quint64 count;
+  quint64 bytes;
+};
+
+// Allocations are only counted when built with ENABLE_ALLOC_STATS
+// (GGVTOGPX_ALLOC_STATS), which replaces the global operator new
+// and, on glibc, the malloc family used by the Qt containers.
+// Counters are per thread; code that joins worker threads adds
+// their counts to the joining thread with add().
+class AllocStats
+{
+public:
+  static bool isAvailable();
+  static AllocCount current();
+  static void add(const AllocCount& count);
+};
+
+// Counts the allocations of the calling thread since construction
+class AllocCounter
+{
+public:
+  AllocCounter() : start(AllocStats::current()) {};
+  AllocCount delta() const;
+private:
+  AllocCount start;
+};
+
+#endif
@@ -0,0 +1,233 @@
+/*
+
+    Content addressed conversion cache
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QString>
+
+#include <cstring>
+
+#include "cache.h"
+#include "trace.h"
+
+static const quint64 kPrime1 = 11400714785074694791ULL;
+static const quint64 kPrime2 = 14029467366897019727ULL;
+static const quint64 kPrime3 = 1609587929392839161ULL;
+static const quint64 kPrime4 = 9650029242287828579ULL;
+static const quint64 kPrime5 = 2870177450012600261ULL;
+
+// chunk size for copying without reflink
+static const qint64 kCopySize = 1024 * 1024;
+
+static inline quint64
+cache_rotl(quint64 x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline quint64
+cache_read64(const unsigned char* p)
+{
+  quint64 v;
+  std::memcpy(&v, p, sizeof(v));
+  return qFromLittleEndian(v);
+}
+
+static inline quint32
+cache_read32(const unsigned char* p)
+{
+  quint32 v;
+  std::memcpy(&v, p, sizeof(v));
+  return qFromLittleEndian(v);
+}
+
+static inline quint64
+cache_round(quint64 acc, quint64 input)
+{
+  acc += input * kPrime2;
+  acc = cache_rotl(acc, 31);
+  return acc * kPrime1;
+}
+
+static inline quint64
+cache_merge_round(quint64 acc, quint64 val)
+{
+  acc ^= cache_round(0, val);
+  return acc * kPrime1 + kPrime4;
+}
+
+quint64
+ConversionCache::hash(const char* data, size_t len, quint64 seed)
+{
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+  const unsigned char* end = p + len;
+  quint64 h;
+
+  if (len >= 32) {
+    quint64 v1 = seed + kPrime1 + kPrime2;
+    quint64 v2 = seed + kPrime2;
+    quint64 v3 = seed;
+    quint64 v4 = seed - kPrime1;
+    const unsigned char* limit = end - 32;
+    do {
+      v1 = cache_round(v1, cache_read64(p));
+      v2 = cache_round(v2, cache_read64(p + 8));
+      v3 = cache_round(v3, cache_read64(p + 16));
+      v4 = cache_round(v4, cache_read64(p + 24));
+      p += 32;
+    } while (p <= limit);
+    h = cache_rotl(v1, 1) + cache_rotl(v2, 7) + cache_rotl(v3, 12) + cache_rotl(v4, 18);
+    h = cache_merge_round(h, v1);
+    h = cache_merge_round(h, v2);
+    h = cache_merge_round(h, v3);
+    h = cache_merge_round(h, v4);
+  } else {
+    h = seed + kPrime5;
+  }
+
+  h += static_cast<quint64>(len);
+
+  while (p + 8 <= end) {
+    h ^= cache_round(0, cache_read64(p));
+    h = cache_rotl(h, 27) * kPrime1 + kPrime4;
+    p += 8;
+  }
+  if (p + 4 <= end) {
+    h ^= static_cast<quint64>(cache_read32(p)) * kPrime1;
+    h = cache_rotl(h, 23) * kPrime2 + kPrime3;
+    p += 4;
+  }
+  while (p < end) {
+    h ^= (*p) * kPrime5;
+    h = cache_rotl(h, 11) * kPrime1;
+    p++;
+  }
+
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+quint64
+ConversionCache::hashFile(QFile* file, quint64 seed)
+{
+  TraceSpan span("cache", "hash");
+  qint64 size = file->size();
+  if (size == 0) {
+    return hash(nullptr, 0, seed);
+  }
+  uchar* data = file->map(0, size);
+  if (data) {
+    quint64 h = hash(reinterpret_cast<const char*>(data), size, seed);
+    file->unmap(data);
+    return h;
+  }
+  file->reset();
+  QByteArray bytes = file->readAll();
+  file->reset();
+  return hash(bytes.constData(), bytes.size(), seed);
+}
+
+// Copy the contents of src to dst. A reflink shares the data blocks
+// on file systems like btrfs and XFS, otherwise the data is copied.
+static bool
+cache_copy(QFile& src, QFileDevice& dst)
+{
+#ifdef FICLONE
+  if (ioctl(dst.handle(), FICLONE, src.handle()) == 0) {
+    return true;
+  }
+#endif
+  QByteArray buffer;
+  while (!src.atEnd()) {
+    buffer = src.read(kCopySize);
+    if (buffer.isEmpty() || dst.write(buffer) != buffer.size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**********************************************************************/
+
+ConversionCache::ConversionCache(const QString& _directory) :
+  directory(_directory)
+{
+  valid = QDir().mkpath(directory);
+}
+
+bool
+ConversionCache::isValid() const
+{
+  return valid;
+}
+
+QString
+ConversionCache::path(quint64 key) const
+{
+  return QDir(directory).filePath(QStringLiteral("%1").arg(key, 16, 16, QChar('0')));
+}
+
+bool
+ConversionCache::fetch(quint64 key, const QString& filename) const
+{
+  TraceSpan span("cache", "fetch", filename);
+  QFile cached(path(key));
+  if (!cached.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QFile out(filename);
+  if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    return false;
+  }
+  return cache_copy(cached, out);
+}
+
+bool
+ConversionCache::store(quint64 key, const QString& filename) const
+{
+  TraceSpan span("cache", "store", filename);
+  QFile result(filename);
+  if (!result.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  // QSaveFile writes to a temporary file and renames it on commit,
+  // so readers never see a partial result
+  QSaveFile out(path(key));
+  if (!out.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  if (!cache_copy(result, out)) {
+    out.cancelWriting();
+    return false;
+  }
+  return out.commit();
+}
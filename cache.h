@@ -0,0 +1,58 @@
+/*
+
+    Content addressed conversion cache
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef CACHE_H_INCLUDED_
+#define CACHE_H_INCLUDED_
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <cstddef>
+
+// Stores conversion results in a directory, one file per key. The
+// key is derived from the input bytes and everything else that
+// influences the output. Results are copied (or reflinked where the
+// file system supports it) and stored atomically, so concurrent
+// conversions can share a cache directory.
+class ConversionCache
+{
+public:
+  explicit ConversionCache(const QString& _directory);
+
+  bool isValid() const;
+  QString path(quint64 key) const;
+  // copy the cached result to filename, false on a miss
+  bool fetch(quint64 key, const QString& filename) const;
+  // store a copy of filename as result for key
+  bool store(quint64 key, const QString& filename) const;
+
+  // XXH64 of the data
+  static quint64 hash(const char* data, size_t len, quint64 seed = 0);
+  // hash of a whole file, memory mapped if possible
+  static quint64 hashFile(QFile* file, quint64 seed = 0);
+private:
+  QString directory;
+  bool valid;
+};
+
+#endif
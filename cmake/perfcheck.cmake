@@ -0,0 +1,103 @@
+# Performance regression check for ggvtogpx
+#
+# Runs one conversion --repeat ITERATIONS times and compares the
+# --stats-file output with the baseline file:
+#
+#   *.rate           calls per second, must not drop below
+#                    baseline - TOLERANCE percent
+#   *.allocs/bytes   per call, must not grow above baseline +
+#                    TOLERANCE percent
+#
+# Only the keys in the baseline are compared, a baseline without
+# *.rate entries checks the allocations only. A baseline key that was
+# not measured or a measurement without allocation counts (a build
+# without ENABLE_ALLOC_STATS) fails the test, a missing baseline skips
+# it. With -DUPDATE=ON the baseline file is rewritten from the current
+# measurement instead, with -DRATES=OFF leaving out the rates.
+#
+# cmake -DGGVTOGPX=<exe> -DINPUT=<ovl> -DNAME=<test> -DBASELINE=<file>
+#       -DITERATIONS=<n> -DTOLERANCE=<percent> [-DUPDATE=ON [-DRATES=OFF]]
+#       -P perfcheck.cmake
+
+foreach (var GGVTOGPX INPUT NAME BASELINE ITERATIONS TOLERANCE)
+  if (NOT DEFINED ${var})
+    message(FATAL_ERROR "perfcheck: ${var} not set")
+  endif()
+endforeach()
+
+set(stats_file ${NAME}.stats)
+execute_process(
+  COMMAND ${GGVTOGPX} --repeat ${ITERATIONS} --stats-file ${stats_file} ${INPUT} ${NAME}.perf.out
+  RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+  message(FATAL_ERROR "perfcheck: ggvtogpx failed (${result})")
+endif()
+
+file(STRINGS ${stats_file} measured REGEX "^[^#]")
+if (NOT measured MATCHES "\\.allocs ")
+  message(FATAL_ERROR "perfcheck: no allocation counts, build with ENABLE_ALLOC_STATS=ON")
+endif()
+
+if (UPDATE)
+  file(WRITE ${BASELINE} "# ggvtogpx performance baseline for ${NAME} (${ITERATIONS} iterations)\n")
+  foreach (line ${measured})
+    if (line MATCHES "\\.calls ")
+      continue()
+    endif()
+    if (DEFINED RATES AND NOT RATES AND line MATCHES "\\.rate ")
+      continue()
+    endif()
+    file(APPEND ${BASELINE} "${line}\n")
+  endforeach()
+  message(STATUS "perfcheck: updated ${BASELINE}")
+  return()
+endif()
+
+# reported as skipped by ctest (SKIP_REGULAR_EXPRESSION)
+if (NOT EXISTS ${BASELINE})
+  message(STATUS "perfcheck: skipped, no baseline ${BASELINE}, run 'make perf-baseline'")
+  return()
+endif()
+
+file(STRINGS ${BASELINE} expected REGEX "^[^#]")
+
+set(failures 0)
+foreach (line ${expected})
+  if (NOT line MATCHES "^([^ ]+) +([0-9]+)$")
+    message(FATAL_ERROR "perfcheck: invalid baseline line: ${line}")
+  endif()
+  set(key ${CMAKE_MATCH_1})
+  set(baseline_value ${CMAKE_MATCH_2})
+
+  set(value "")
+  foreach (m ${measured})
+    if (m MATCHES "^([^ ]+) +([0-9]+)$" AND CMAKE_MATCH_1 STREQUAL key)
+      set(value ${CMAKE_MATCH_2})
+    endif()
+  endforeach()
+  if (value STREQUAL "")
+    message(FATAL_ERROR "perfcheck: ${key}: in baseline but not measured")
+  endif()
+
+  if (key MATCHES "\\.rate$")
+    math(EXPR limit "${baseline_value} * (100 - ${TOLERANCE}) / 100")
+    if (value LESS limit)
+      message(WARNING "perfcheck: ${key}: ${value} < ${limit} (baseline ${baseline_value})")
+      math(EXPR failures "${failures} + 1")
+    else()
+      message(STATUS "perfcheck: ${key}: ${value} (baseline ${baseline_value})")
+    endif()
+  else()
+    math(EXPR limit "${baseline_value} * (100 + ${TOLERANCE}) / 100")
+    if (value GREATER limit)
+      message(WARNING "perfcheck: ${key}: ${value} > ${limit} (baseline ${baseline_value})")
+      math(EXPR failures "${failures} + 1")
+    else()
+      message(STATUS "perfcheck: ${key}: ${value} (baseline ${baseline_value})")
+    endif()
+  endif()
+endforeach()
+
+if (failures GREATER 0)
+  message(FATAL_ERROR "perfcheck: ${NAME}: ${failures} regression(s) beyond ${TOLERANCE}%")
+endif()
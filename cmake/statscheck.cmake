@@ -0,0 +1,41 @@
+# Allocation attribution check for ggvtogpx
+#
+# Converts INPUT once with the default options and once with
+# --no-pipeline and compares the "write.gpx.allocs" entries of the
+# --stats-file output. Both have to be non-zero and equal, the work
+# done on other threads must not get lost from the write phase.
+#
+# cmake -DGGVTOGPX=<exe> -DINPUT=<ovl> -DNAME=<test> -P statscheck.cmake
+
+foreach (var GGVTOGPX INPUT NAME)
+  if (NOT DEFINED ${var})
+    message(FATAL_ERROR "statscheck: ${var} not set")
+  endif()
+endforeach()
+
+foreach (run default no-pipeline)
+  if (run STREQUAL "no-pipeline")
+    set(args --no-pipeline)
+  else()
+    set(args "")
+  endif()
+  execute_process(
+    COMMAND ${GGVTOGPX} ${args} --stats-file ${NAME}.${run}.stats ${INPUT} ${NAME}.${run}.out
+    RESULT_VARIABLE result)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "statscheck: ggvtogpx ${args} failed (${result})")
+  endif()
+  file(STRINGS ${NAME}.${run}.stats lines REGEX "^write\\.gpx\\.allocs ")
+  if (NOT lines MATCHES "^write\\.gpx\\.allocs ([0-9]+)$")
+    message(FATAL_ERROR "statscheck: ${run}: no write.gpx.allocs entry")
+  endif()
+  set(allocs_${run} ${CMAKE_MATCH_1})
+  if (allocs_${run} EQUAL 0)
+    message(FATAL_ERROR "statscheck: ${run}: no allocations in the write phase")
+  endif()
+endforeach()
+
+if (NOT allocs_default EQUAL allocs_no-pipeline)
+  message(FATAL_ERROR "statscheck: write.gpx.allocs ${allocs_default} != ${allocs_no-pipeline} with --no-pipeline")
+endif()
+message(STATUS "statscheck: write.gpx.allocs ${allocs_default}")
@@ -0,0 +1,58 @@
+# Trace output check for ggvtogpx
+#
+# Parses the --trace file as JSON and fails unless it contains a
+# complete ("ph":"X") event for each of the phases given in PHASES.
+#
+# cmake -DTRACE=<file> -DPHASES=probe,read,write -P tracecheck.cmake
+#
+# string(JSON) requires CMake 3.19.
+
+cmake_minimum_required(VERSION 3.19)
+
+foreach (var TRACE PHASES)
+  if (NOT DEFINED ${var})
+    message(FATAL_ERROR "tracecheck: ${var} not set")
+  endif()
+endforeach()
+
+string(REPLACE "," ";" PHASES "${PHASES}")
+
+if (NOT EXISTS ${TRACE})
+  message(FATAL_ERROR "tracecheck: ${TRACE} not found")
+endif()
+file(READ ${TRACE} trace)
+
+string(JSON count ERROR_VARIABLE error LENGTH "${trace}" traceEvents)
+if (error)
+  message(FATAL_ERROR "tracecheck: ${TRACE}: ${error}")
+endif()
+if (count EQUAL 0)
+  message(FATAL_ERROR "tracecheck: ${TRACE}: no events")
+endif()
+
+set(found "")
+math(EXPR last "${count} - 1")
+foreach (i RANGE ${last})
+  string(JSON ph GET "${trace}" traceEvents ${i} ph)
+  if (NOT ph STREQUAL "X")
+    continue()
+  endif()
+  foreach (key name cat ts dur pid tid)
+    string(JSON value ERROR_VARIABLE error GET "${trace}" traceEvents ${i} ${key})
+    if (error)
+      message(FATAL_ERROR "tracecheck: ${TRACE}: event ${i} without ${key}")
+    endif()
+  endforeach()
+  string(JSON cat GET "${trace}" traceEvents ${i} cat)
+  string(JSON name GET "${trace}" traceEvents ${i} name)
+  if (cat STREQUAL "phase")
+    list(APPEND found ${name})
+  endif()
+endforeach()
+
+foreach (phase ${PHASES})
+  if (NOT phase IN_LIST found)
+    message(FATAL_ERROR "tracecheck: ${TRACE}: no span for phase ${phase}")
+  endif()
+endforeach()
+message(STATUS "tracecheck: ${count} events, phases ${found}")
@@ -0,0 +1,48 @@
+# Watch mode check for ggvtogpx
+#
+# Starts ggvtogpx --watch on an empty directory, copies INPUT into it
+# once the watcher is running and compares the converted file with
+# EXPECTED. The watcher does not exit by itself, it is stopped after
+# TIMEOUT seconds.
+#
+# cmake -DGGVTOGPX=<exe> -DINPUT=<ovl> -DEXPECTED=<gpx> -DNAME=<test>
+#       -DTIMEOUT=<seconds> -P watchcheck.cmake
+#
+# The copy runs in a second instance of this script with -DFEED=<dir>
+# next to the watcher.
+
+if (DEFINED FEED)
+  # give the watcher time to set up its inotify watch
+  execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1)
+  file(COPY ${INPUT} DESTINATION ${FEED})
+  return()
+endif()
+
+foreach (var GGVTOGPX INPUT EXPECTED NAME TIMEOUT)
+  if (NOT DEFINED ${var})
+    message(FATAL_ERROR "watchcheck: ${var} not set")
+  endif()
+endforeach()
+
+set(watch_dir ${NAME}-in)
+set(out_dir ${NAME}-out)
+file(REMOVE_RECURSE ${watch_dir} ${out_dir})
+file(MAKE_DIRECTORY ${watch_dir} ${out_dir})
+
+execute_process(
+  COMMAND ${GGVTOGPX} --watch ${watch_dir} --out ${out_dir}
+  COMMAND ${CMAKE_COMMAND} -DFEED=${watch_dir} -DINPUT=${INPUT} -P ${CMAKE_CURRENT_LIST_FILE}
+  TIMEOUT ${TIMEOUT})
+
+get_filename_component(base ${INPUT} NAME_WLE)
+set(output ${out_dir}/${base}.gpx)
+if (NOT EXISTS ${output})
+  message(FATAL_ERROR "watchcheck: ${output} was not written within ${TIMEOUT} seconds")
+endif()
+execute_process(
+  COMMAND ${CMAKE_COMMAND} -E compare_files ${EXPECTED} ${output}
+  RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+  message(FATAL_ERROR "watchcheck: ${output} differs from ${EXPECTED}")
+endif()
+message(STATUS "watchcheck: ${output} matches ${EXPECTED}")
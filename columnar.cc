@@ -0,0 +1,254 @@
+/*
+
+    Support for columnar binary writing
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+ */
+
+#include <QByteArray>
+#include <QHash>
+#include <QtEndian>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "columnar.h"
+
+static const char kMagic[8] = {'G', 'G', 'V', 'C', 'O', 'L', '\0', '\0'};
+
+struct ColumnarList {
+  quint64 first_point;
+  quint64 point_count;
+  quint32 name;
+  double min_lat;
+  double min_lon;
+  double max_lat;
+  double max_lon;
+};
+
+// collects the string table, equal strings are stored once
+class ColumnarStrings
+{
+public:
+  quint32 add(const QString& str)
+  {
+    if (str.isEmpty()) {
+      return ColumnarFormat::kNoName;
+    }
+    auto it = index.constFind(str);
+    if (it != index.constEnd()) {
+      return it.value();
+    }
+    quint32 id = static_cast<quint32>(offsets.size());
+    index.insert(str, id);
+    offsets.push_back(data.size());
+    data += str.toUtf8();
+    data += '\0';
+    return id;
+  }
+
+  QHash<QString, quint32> index;
+  std::vector<quint64> offsets;
+  QByteArray data;
+};
+
+static void
+columnar_put_u32(QByteArray& out, quint32 value)
+{
+  value = qToLittleEndian(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void
+columnar_put_u64(QByteArray& out, quint64 value)
+{
+  value = qToLittleEndian(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void
+columnar_put_double(QByteArray& out, double value)
+{
+  quint64 bits;
+  static_assert(sizeof(bits) == sizeof(value), "unexpected double size");
+  std::memcpy(&bits, &value, sizeof(bits));
+  columnar_put_u64(out, bits);
+}
+
+static quint64
+columnar_align(quint64 offset)
+{
+  return (offset + 7) & ~static_cast<quint64>(7);
+}
+
+template<typename T>
+static void
+columnar_write_array(QIODevice* io, std::vector<T>& values)
+{
+  for (auto&& v : values) {
+    v = qToLittleEndian(v);
+  }
+  io->write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+static void
+columnar_write_padding(QIODevice* io, quint64 size)
+{
+  static const char zero[8] = {};
+  if (size % 8 != 0) {
+    io->write(zero, 8 - size % 8);
+  }
+}
+
+void
+ColumnarFormat::write(QIODevice* io, const Geodata* geodata)
+{
+  // Collect the columns. Points are ordered as waypoints, route
+  // points, track points. Doubles are kept as bit patterns to be
+  // able to byte swap them on big endian hosts.
+  size_t point_count = geodata->getWaypoints().size();
+  for (auto&& route : geodata->getRoutes()) {
+    point_count += route.getWaypoints().size();
+  }
+  for (auto&& track : geodata->getTracks()) {
+    point_count += track.getWaypoints().size();
+  }
+
+  std::vector<quint64> lat;
+  std::vector<quint64> lon;
+  std::vector<quint64> ele;
+  std::vector<quint32> names;
+  lat.reserve(point_count);
+  lon.reserve(point_count);
+  ele.reserve(point_count);
+  names.reserve(point_count);
+  ColumnarStrings strings;
+  std::vector<ColumnarList> lists;
+  lists.reserve(geodata->getRoutes().size() + geodata->getTracks().size());
+
+  auto add_point = [&](const Waypoint* waypoint) {
+    quint64 bits;
+    std::memcpy(&bits, &waypoint->latitude, sizeof(bits));
+    lat.push_back(bits);
+    std::memcpy(&bits, &waypoint->longitude, sizeof(bits));
+    lon.push_back(bits);
+    std::memcpy(&bits, &waypoint->elevation, sizeof(bits));
+    ele.push_back(bits);
+    names.push_back(strings.add(waypoint->name));
+  };
+
+  auto add_list = [&](const WaypointList* list) {
+    ColumnarList entry{lat.size(), list->getWaypoints().size(), strings.add(list->name), NAN, NAN, NAN, NAN};
+    for (auto&& waypoint : list->getWaypoints()) {
+      if (!(waypoint.latitude >= entry.min_lat)) {
+        entry.min_lat = waypoint.latitude;
+      }
+      if (!(waypoint.latitude <= entry.max_lat)) {
+        entry.max_lat = waypoint.latitude;
+      }
+      if (!(waypoint.longitude >= entry.min_lon)) {
+        entry.min_lon = waypoint.longitude;
+      }
+      if (!(waypoint.longitude <= entry.max_lon)) {
+        entry.max_lon = waypoint.longitude;
+      }
+      add_point(&waypoint);
+    }
+    lists.push_back(entry);
+  };
+
+  for (auto&& waypoint : geodata->getWaypoints()) {
+    add_point(&waypoint);
+  }
+  for (auto&& route : geodata->getRoutes()) {
+    add_list(&route);
+  }
+  for (auto&& track : geodata->getTracks()) {
+    add_list(&track);
+  }
+
+  // Section offsets, every section starts 8 byte aligned
+  const quint64 lists_offset = kHeaderSize;
+  const quint64 lat_offset = lists_offset + lists.size() * kListEntrySize;
+  const quint64 lon_offset = lat_offset + point_count * sizeof(double);
+  const quint64 ele_offset = lon_offset + point_count * sizeof(double);
+  const quint64 names_offset = ele_offset + point_count * sizeof(double);
+  const quint64 strings_offset = columnar_align(names_offset + point_count * sizeof(quint32));
+
+  QByteArray header;
+  header.reserve(kHeaderSize);
+  header.append(kMagic, sizeof(kMagic));
+  columnar_put_u32(header, kVersion);
+  columnar_put_u32(header, kHeaderSize);
+  columnar_put_u32(header, geodata->getWaypoints().size());
+  columnar_put_u32(header, geodata->getRoutes().size());
+  columnar_put_u32(header, geodata->getTracks().size());
+  columnar_put_u32(header, 0);
+  columnar_put_u64(header, point_count);
+  columnar_put_u64(header, lists_offset);
+  columnar_put_u64(header, lat_offset);
+  columnar_put_u64(header, lon_offset);
+  columnar_put_u64(header, ele_offset);
+  columnar_put_u64(header, names_offset);
+  columnar_put_u64(header, strings_offset);
+  columnar_put_u32(header, strings.offsets.size());
+  columnar_put_u32(header, 0);
+  auto bounds = geodata->getBounds();
+  if (point_count > 0) {
+    columnar_put_double(header, bounds.first.latitude);
+    columnar_put_double(header, bounds.first.longitude);
+    columnar_put_double(header, bounds.second.latitude);
+    columnar_put_double(header, bounds.second.longitude);
+  } else {
+    for (int i = 0; i < 4; ++i) {
+      columnar_put_double(header, NAN);
+    }
+  }
+  Q_ASSERT(header.size() == kHeaderSize);
+
+  for (auto&& entry : lists) {
+    columnar_put_u64(header, entry.first_point);
+    columnar_put_u64(header, entry.point_count);
+    columnar_put_u32(header, entry.name);
+    columnar_put_u32(header, 0);
+    columnar_put_double(header, entry.min_lat);
+    columnar_put_double(header, entry.min_lon);
+    columnar_put_double(header, entry.max_lat);
+    columnar_put_double(header, entry.max_lon);
+  }
+  io->write(header);
+
+  columnar_write_array(io, lat);
+  columnar_write_array(io, lon);
+  columnar_write_array(io, ele);
+  columnar_write_array(io, names);
+  columnar_write_padding(io, names.size() * sizeof(quint32));
+
+  // string offsets are relative to the start of the string data,
+  // the additional last entry gives the end of the last string
+  strings.offsets.push_back(strings.data.size());
+  columnar_write_array(io, strings.offsets);
+  io->write(strings.data);
+  columnar_write_padding(io, strings.data.size());
+}
+
+const QString ColumnarFormat::getName()
+{
+  return "columnar";
+}
@@ -0,0 +1,48 @@
+/*
+
+    Support for columnar binary writing
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef COLUMNAR_H_INCLUDED_
+#define COLUMNAR_H_INCLUDED_
+
+#include <QIODevice>
+#include <QString>
+
+#include "format.h"
+#include "geodata.h"
+
+// Flat little endian file with offset tables and contiguous
+// coordinate arrays that can be memory mapped by analysis tools.
+// The layout is described in README.rst.
+class ColumnarFormat : public Format
+{
+public:
+  ColumnarFormat() = default;
+
+  void write(QIODevice* io, const Geodata* geodata) override;
+  virtual const QString getName() override;
+
+  static const quint32 kVersion = 1;
+  static const quint32 kHeaderSize = 128;
+  static const quint32 kListEntrySize = 56;
+  static const quint32 kNoName = 0xffffffff;
+};
+
+#endif
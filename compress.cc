@@ -0,0 +1,297 @@
+/*
+
+    Compressed output (gzip, zstd) on a separate thread
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <QByteArray>
+#include <QString>
+
+#include <cstring>
+
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "compress.h"
+#include "trace.h"
+
+// uncompressed bytes handed to the worker at once
+static const qsizetype kChunkSize = 256 * 1024;
+// chunks waiting for the worker before the writer blocks
+static const size_t kMaxQueued = 4;
+// output buffer growth step of the compressors
+static const size_t kOutputStep = 64 * 1024;
+
+class Compressor
+{
+public:
+  virtual ~Compressor() = default;
+  // compress len bytes and append the result to out, finish ends
+  // the stream
+  virtual bool compress(const char* data, size_t len, bool finish, QByteArray& out) = 0;
+};
+
+/**********************************************************************/
+
+class GzipCompressor : public Compressor
+{
+public:
+  GzipCompressor()
+  {
+    std::memset(&stream, 0, sizeof(stream));
+    // windowBits 15 + 16 selects the gzip wrapper, the header has no
+    // file name and mtime 0, so the output is reproducible
+    ok = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+  }
+
+  ~GzipCompressor() override
+  {
+    if (ok) {
+      deflateEnd(&stream);
+    }
+  }
+
+  bool compress(const char* data, size_t len, bool finish, QByteArray& out) override
+  {
+    if (!ok) {
+      return false;
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(len);
+    int ret = Z_OK;
+    do {
+      qsizetype pos = out.size();
+      out.resize(pos + kOutputStep);
+      stream.next_out = reinterpret_cast<Bytef*>(out.data() + pos);
+      stream.avail_out = kOutputStep;
+      ret = deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+      if (ret == Z_STREAM_ERROR) {
+        return false;
+      }
+      out.resize(pos + kOutputStep - stream.avail_out);
+    } while (stream.avail_out == 0 || (finish && ret != Z_STREAM_END));
+    return true;
+  }
+private:
+  z_stream stream;
+  bool ok;
+};
+
+#ifdef HAVE_ZSTD
+class ZstdCompressor : public Compressor
+{
+public:
+  ZstdCompressor() : ctx(ZSTD_createCCtx())
+  {
+    if (ctx) {
+      ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, 3);
+    }
+  }
+
+  ~ZstdCompressor() override
+  {
+    ZSTD_freeCCtx(ctx);
+  }
+
+  bool compress(const char* data, size_t len, bool finish, QByteArray& out) override
+  {
+    if (!ctx) {
+      return false;
+    }
+    ZSTD_inBuffer input = {data, len, 0};
+    bool done = false;
+    while (!done) {
+      qsizetype pos = out.size();
+      out.resize(pos + kOutputStep);
+      ZSTD_outBuffer output = {out.data() + pos, kOutputStep, 0};
+      size_t remaining = ZSTD_compressStream2(ctx, &output, &input, finish ? ZSTD_e_end : ZSTD_e_continue);
+      if (ZSTD_isError(remaining)) {
+        return false;
+      }
+      out.resize(pos + output.pos);
+      done = finish ? remaining == 0 : input.pos == input.size;
+    }
+    return true;
+  }
+private:
+  ZSTD_CCtx* ctx;
+};
+#endif
+
+/**********************************************************************/
+
+CompressDevice::CompressDevice(QIODevice* _target, Method _method) :
+  target(_target), method(_method), worker_allocs{0, 0}, finishing(false), failed(false)
+{
+}
+
+CompressDevice::~CompressDevice()
+{
+  close();
+}
+
+bool
+CompressDevice::open(OpenMode mode)
+{
+  if ((mode & QIODevice::ReadOnly) || !isSupported(method)) {
+    return false;
+  }
+  if (method == Gzip) {
+    compressor = std::make_unique<GzipCompressor>();
+  }
+#ifdef HAVE_ZSTD
+  if (method == Zstd) {
+    compressor = std::make_unique<ZstdCompressor>();
+  }
+#endif
+  pending.reserve(kChunkSize);
+  finishing = false;
+  failed = false;
+  worker = std::thread(&CompressDevice::run, this);
+  return QIODevice::open(mode);
+}
+
+void
+CompressDevice::close()
+{
+  if (!isOpen()) {
+    return;
+  }
+  if (!pending.isEmpty()) {
+    enqueue(std::move(pending));
+    pending = QByteArray();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finishing = true;
+  }
+  cond.notify_all();
+  worker.join();
+  // the worker's allocations count for the phase that closes the device
+  AllocStats::add(worker_allocs);
+  compressor.reset();
+  QIODevice::close();
+}
+
+bool
+CompressDevice::isSequential() const
+{
+  return true;
+}
+
+bool
+CompressDevice::hasError() const
+{
+  return failed;
+}
+
+CompressDevice::Method
+CompressDevice::methodForFileName(const QString& filename)
+{
+  if (filename.endsWith(".gz")) {
+    return Gzip;
+  } else if (filename.endsWith(".zst")) {
+    return Zstd;
+  }
+  return None;
+}
+
+bool
+CompressDevice::isSupported(Method method)
+{
+  switch (method) {
+  case Gzip:
+    return true;
+  case Zstd:
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  default:
+    return false;
+  }
+}
+
+qint64
+CompressDevice::readData([[maybe_unused]] char* data, [[maybe_unused]] qint64 maxlen)
+{
+  return -1;
+}
+
+qint64
+CompressDevice::writeData(const char* data, qint64 len)
+{
+  if (failed) {
+    return -1;
+  }
+  pending.append(data, len);
+  if (pending.size() >= kChunkSize) {
+    enqueue(std::move(pending));
+    pending = QByteArray();
+    pending.reserve(kChunkSize);
+  }
+  return len;
+}
+
+void
+CompressDevice::enqueue(QByteArray&& chunk)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  cond.wait(lock, [this] { return queue.size() < kMaxQueued; });
+  queue.push_back(std::move(chunk));
+  cond.notify_all();
+}
+
+void
+CompressDevice::run()
+{
+  AllocCounter allocs;
+  QByteArray out;
+  for (;;) {
+    QByteArray chunk;
+    bool last = false;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [this] { return !queue.empty() || finishing; });
+      if (!queue.empty()) {
+        chunk = std::move(queue.front());
+        queue.pop_front();
+      } else {
+        last = true;
+      }
+    }
+    cond.notify_all();
+
+    TraceSpan span("writer", "compress");
+    out.clear();
+    if (!failed) {
+      if (!compressor->compress(chunk.constData(), chunk.size(), last, out) ||
+          target->write(out) != out.size()) {
+        failed = true;
+      }
+    }
+    if (last) {
+      break;
+    }
+  }
+  worker_allocs = allocs.delta();
+}
@@ -0,0 +1,91 @@
+/*
+
+    Compressed output (gzip, zstd) on a separate thread
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef COMPRESS_H_INCLUDED_
+#define COMPRESS_H_INCLUDED_
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "allocstats.h"
+
+class Compressor;
+
+// Write-only device that compresses everything written to it into
+// the target device. The data is collected in chunks that are
+// compressed and written by a worker thread, so compression overlaps
+// with the formatting done by the writer. close() finishes the
+// stream and waits for the worker.
+class CompressDevice : public QIODevice
+{
+public:
+  enum Method {
+    None,
+    Gzip,
+    Zstd
+  };
+
+  CompressDevice(QIODevice* _target, Method _method);
+  ~CompressDevice() override;
+
+  CompressDevice(const CompressDevice&) = delete;
+  CompressDevice& operator=(const CompressDevice&) = delete;
+  CompressDevice(CompressDevice&&) = delete;
+  CompressDevice& operator=(CompressDevice&&) = delete;
+
+  bool open(OpenMode mode) override;
+  void close() override;
+  bool isSequential() const override;
+  bool hasError() const;
+
+  // select the method by file name extension (.gz, .zst)
+  static Method methodForFileName(const QString& filename);
+  static bool isSupported(Method method);
+protected:
+  qint64 readData(char* data, qint64 maxlen) override;
+  qint64 writeData(const char* data, qint64 len) override;
+private:
+  void enqueue(QByteArray&& chunk);
+  void run();
+
+  QIODevice* target;
+  Method method;
+  std::unique_ptr<Compressor> compressor;
+  QByteArray pending;
+  std::deque<QByteArray> queue;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::thread worker;
+  AllocCount worker_allocs;
+  bool finishing;
+  std::atomic<bool> failed;
+};
+
+#endif
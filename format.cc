@@ -20,6 +20,8 @@
 
 */
 
+#include <QBuffer>
+
 #include "format.h"
 
 bool
@@ -33,6 +35,15 @@ Format::read([[maybe_unused]] QIODevice* io, [[maybe_unused]] Geodata* geodata)
 {
 }
 
+void
+Format::readBuffer(const QByteArray& data, Geodata* geodata)
+{
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+  read(&buffer, geodata);
+}
+
 void
 Format::write([[maybe_unused]] QIODevice* io, [[maybe_unused]] const Geodata* geodata)
 {
@@ -23,6 +23,7 @@
 #ifndef FORMAT_H_INCLUDED_
 #define FORMAT_H_INCLUDED_
 
+#include <QByteArray>
 #include <QIODevice>
 
 #include "geodata.h"
@@ -40,6 +41,9 @@ public:
 
   virtual bool probe([[maybe_unused]] QIODevice* io);
   virtual void read([[maybe_unused]] QIODevice* io, [[maybe_unused]] Geodata* geodata);
+  // Read from a file already loaded into memory. The default wraps
+  // the buffer into a QBuffer and calls read().
+  virtual void readBuffer(const QByteArray& data, Geodata* geodata);
   virtual void write([[maybe_unused]] QIODevice* io, [[maybe_unused]] const Geodata* geodata);
   virtual const QString getName();
 
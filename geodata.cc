@@ -29,42 +29,121 @@
 
 /**********************************************************************/
 
+Waypoint&
+WaypointList::emplacePoint(double lat, double lon, double ele)
+{
+  return waypoint_list.emplace_back(lat, lon, ele);
+}
+
 void
-WaypointList::addWaypoint(std::unique_ptr<Waypoint>& waypoint)
+WaypointList::addWaypoint(Waypoint&& waypoint)
 {
   waypoint_list.push_back(std::move(waypoint));
 };
 
-std::unique_ptr<Waypoint>
+void
+WaypointList::reserve(size_t count)
+{
+  waypoint_list.reserve(count);
+}
+
+Waypoint
 WaypointList::extractFirstWaypoint()
 {
-  auto ret = std::move(waypoint_list.front());
-  waypoint_list.pop_front();
+  Waypoint ret = std::move(waypoint_list.front());
+  waypoint_list.erase(waypoint_list.begin());
   return ret;
 };
 
-const std::list<std::unique_ptr<Waypoint>>&
-                                        WaypointList::getWaypoints() const
+const std::vector<Waypoint>&
+WaypointList::getWaypoints() const
 {
   return waypoint_list;
 }
 
+std::vector<Waypoint>&
+WaypointList::getWaypoints()
+{
+  return waypoint_list;
+}
+
+void
+WaypointList::retainWaypoints(const std::vector<bool>& keep)
+{
+  size_t count = 0;
+  for (size_t index = 0; index < waypoint_list.size(); ++index) {
+    if (index < keep.size() && keep[index]) {
+      if (count != index) {
+        waypoint_list[count] = std::move(waypoint_list[index]);
+      }
+      count++;
+    }
+  }
+  waypoint_list.resize(count);
+}
+
+/**********************************************************************/
+
+QString
+NamePool::intern(const QString& name)
+{
+  if (name.isEmpty()) {
+    return name;
+  }
+  auto it = names.constFind(name);
+  if (it != names.constEnd()) {
+    return *it;
+  }
+  names.insert(name);
+  return name;
+}
+
+void
+NamePool::reserve(size_t count)
+{
+  names.reserve(names.size() + static_cast<qsizetype>(count));
+}
+
+qsizetype
+NamePool::size() const
+{
+  return names.size();
+}
+
 /**********************************************************************/
 
-const std::list<std::unique_ptr<Waypoint>>&
-                                        Geodata::getWaypoints() const
+const std::deque<Waypoint>&
+Geodata::getWaypoints() const
+{
+  return waypoints;
+};
+
+const std::deque<WaypointList>&
+Geodata::getRoutes() const
+{
+  return routes;
+};
+
+const std::deque<WaypointList>&
+Geodata::getTracks() const
+{
+  return tracks;
+};
+
+std::deque<Waypoint>&
+Geodata::getWaypoints()
 {
   return waypoints;
 };
 
-const std::list<std::unique_ptr<WaypointList>>&
-    Geodata::getRoutes() const
+std::deque<WaypointList>&
+Geodata::getRoutes()
 {
   return routes;
 };
 
-const std::list<std::unique_ptr<WaypointList>>&
-    Geodata::getTracks() const
+std::deque<WaypointList>&
+Geodata::getTracks()
 {
   return tracks;
 };
@@ -82,31 +161,129 @@ Geodata::getDebugLevel()
 };
 
 void
-Geodata::addWaypoint(std::unique_ptr<Waypoint>& waypoint)
+Geodata::setObserver(GeodataObserver* _observer)
+{
+  observer = _observer;
+};
+
+void
+Geodata::reserve(size_t object_count)
+{
+  names.reserve(object_count);
+}
+
+const NamePool&
+Geodata::getNames() const
+{
+  return names;
+}
+
+void
+Geodata::internNames(WaypointList* list)
+{
+  list->name = names.intern(list->name);
+  for (auto&& waypoint : list->getWaypoints()) {
+    waypoint.name = names.intern(waypoint.name);
+  }
+}
+
+// Called when an object is complete, the reader does not change it
+// afterwards
+void
+Geodata::waypointAdded(Waypoint* waypoint)
 {
   if (getDebugLevel() > 2) {
     qDebug() << "waypt_add()";
   }
-  waypoints.push_back(std::move(waypoint));
-};
+  waypoint->name = names.intern(waypoint->name);
+  if (observer) {
+    observer->waypointAdded(waypoint);
+  }
+}
 
+void
+Geodata::routeAdded(WaypointList* route)
+{
+  if (getDebugLevel() > 2) {
+    qDebug() << "route_add_head()";
+  }
+  internNames(route);
+  if (observer) {
+    observer->routeAdded(route);
+  }
+}
 
 void
-Geodata::addTrack(std::unique_ptr<WaypointList>& track)
+Geodata::trackAdded(WaypointList* track)
 {
   if (getDebugLevel() > 2) {
     qDebug() << "track_add_head()";
   }
-  tracks.push_back(std::move(track));
+  internNames(track);
+  if (observer) {
+    observer->trackAdded(track);
+  }
+}
+
+Waypoint&
+Geodata::emplaceWaypoint(double lat, double lon, const QString& name)
+{
+  Waypoint& waypoint = waypoints.emplace_back(lat, lon, name);
+  waypointAdded(&waypoint);
+  return waypoint;
+}
+
+void
+Geodata::addWaypoint(Waypoint&& waypoint)
+{
+  waypoints.push_back(std::move(waypoint));
+  waypointAdded(&waypoints.back());
 };
 
+WaypointList&
+Geodata::beginRoute(const QString& name)
+{
+  Q_ASSERT(!open_list);
+  open_list = &routes.emplace_back(name);
+  return *open_list;
+}
+
 void
-Geodata::addRoute(std::unique_ptr<WaypointList>& route)
+Geodata::endRoute()
+{
+  Q_ASSERT(open_list == &routes.back());
+  open_list = nullptr;
+  routeAdded(&routes.back());
+}
+
+WaypointList&
+Geodata::beginTrack(const QString& name)
+{
+  Q_ASSERT(!open_list);
+  open_list = &tracks.emplace_back(name);
+  return *open_list;
+}
+
+void
+Geodata::endTrack()
+{
+  Q_ASSERT(open_list == &tracks.back());
+  open_list = nullptr;
+  trackAdded(&tracks.back());
+}
+
+void
+Geodata::addRoute(WaypointList&& route)
 {
-  if (getDebugLevel() > 2) {
-    qDebug() << "route_add_head()";
-  }
   routes.push_back(std::move(route));
+  routeAdded(&routes.back());
+};
+
+void
+Geodata::addTrack(WaypointList&& track)
+{
+  tracks.push_back(std::move(track));
+  trackAdded(&tracks.back());
 };
 
 std::pair<Waypoint,Waypoint>
@@ -121,49 +298,49 @@ Geodata::getBounds() const
   Waypoint max(kMinLat, kMinLon);
 
   for (auto&& route : std::as_const(getRoutes())) {
-    for (auto&& waypoint : std::as_const(route->getWaypoints())) {
-      if (waypoint->latitude > max.latitude) {
-        max.latitude = waypoint->latitude;
+    for (auto&& waypoint : std::as_const(route.getWaypoints())) {
+      if (waypoint.latitude > max.latitude) {
+        max.latitude = waypoint.latitude;
       }
-      if (waypoint->latitude < min.latitude) {
-        min.latitude = waypoint->latitude;
+      if (waypoint.latitude < min.latitude) {
+        min.latitude = waypoint.latitude;
       }
-      if (waypoint->longitude > max.longitude) {
-        max.longitude = waypoint->longitude;
+      if (waypoint.longitude > max.longitude) {
+        max.longitude = waypoint.longitude;
       }
-      if (waypoint->longitude < min.longitude) {
-        min.longitude = waypoint->longitude;
+      if (waypoint.longitude < min.longitude) {
+        min.longitude = waypoint.longitude;
       }
     }
   }
   for (auto&& track : std::as_const(getTracks())) {
-    for (auto&& waypoint : std::as_const(track->getWaypoints())) {
-      if (waypoint->latitude > max.latitude) {
-        max.latitude = waypoint->latitude;
+    for (auto&& waypoint : std::as_const(track.getWaypoints())) {
+      if (waypoint.latitude > max.latitude) {
+        max.latitude = waypoint.latitude;
       }
-      if (waypoint->latitude < min.latitude) {
-        min.latitude = waypoint->latitude;
+      if (waypoint.latitude < min.latitude) {
+        min.latitude = waypoint.latitude;
       }
-      if (waypoint->longitude > max.longitude) {
-        max.longitude = waypoint->longitude;
+      if (waypoint.longitude > max.longitude) {
+        max.longitude = waypoint.longitude;
       }
-      if (waypoint->longitude < min.longitude) {
-        min.longitude = waypoint->longitude;
+      if (waypoint.longitude < min.longitude) {
+        min.longitude = waypoint.longitude;
       }
     }
   }
   for (auto&& waypoint : std::as_const(getWaypoints())) {
-    if (waypoint->latitude > max.latitude) {
-      max.latitude = waypoint->latitude;
+    if (waypoint.latitude > max.latitude) {
+      max.latitude = waypoint.latitude;
     }
-    if (waypoint->latitude < min.latitude) {
-      min.latitude = waypoint->latitude;
+    if (waypoint.latitude < min.latitude) {
+      min.latitude = waypoint.latitude;
     }
-    if (waypoint->longitude > max.longitude) {
-      max.longitude = waypoint->longitude;
+    if (waypoint.longitude > max.longitude) {
+      max.longitude = waypoint.longitude;
     }
-    if (waypoint->longitude < min.longitude) {
-      min.longitude = waypoint->longitude;
+    if (waypoint.longitude < min.longitude) {
+      min.longitude = waypoint.longitude;
     }
   }
   return std::make_pair(min,max);
@@ -23,59 +23,126 @@
 #ifndef GEODATA_H_INCLUDED_
 #define GEODATA_H_INCLUDED_
 
+#include <QSet>
 #include <QString>
 
 #include <cmath>
-#include <list>
-#include <memory>
+#include <deque>
+#include <vector>
 
 class Waypoint
 {
 public:
   Waypoint() : latitude(NAN), longitude(NAN), elevation(NAN) {};
   Waypoint(double lat, double lon) : latitude(lat), longitude(lon),elevation(NAN) {};
-  Waypoint(double lat, double lon, QString& n) : latitude(lat), longitude(lon), elevation(NAN), name(n) {}
+  Waypoint(double lat, double lon, double ele) : latitude(lat), longitude(lon), elevation(ele) {};
+  Waypoint(double lat, double lon, const QString& n) : latitude(lat), longitude(lon), elevation(NAN), name(n) {}
   double latitude;
   double longitude;
   double elevation;
   QString name;
 };
 
+// Points are stored by value, so building a list does not allocate
+// per point
 class WaypointList
 {
 public:
   WaypointList() = default;
-
-  void addWaypoint(std::unique_ptr<Waypoint>& waypoint);
-  std::unique_ptr<Waypoint> extractFirstWaypoint();
-  const std::list<std::unique_ptr<Waypoint>>& getWaypoints() const;
+  explicit WaypointList(const QString& _name) : name(_name) {};
+
+  Waypoint& emplacePoint(double lat, double lon, double ele = NAN);
+  void addWaypoint(Waypoint&& waypoint);
+  // capacity hint, callers cap counts read from files
+  void reserve(size_t count);
+  Waypoint extractFirstWaypoint();
+  const std::vector<Waypoint>& getWaypoints() const;
+  std::vector<Waypoint>& getWaypoints();
+  // keep only the waypoints with keep[index] set
+  void retainWaypoints(const std::vector<bool>& keep);
 
   QString name;
 private:
-  std::list<std::unique_ptr<Waypoint>> waypoint_list;
+  std::vector<Waypoint> waypoint_list;
 };
 
-class Geodata
+// Keeps one copy of every distinct name. Interned names share their
+// string data, so repeated labels and generated names like "RPT001"
+// are stored once and can be recognized by their data pointer.
+class NamePool
 {
 public:
-  Geodata() : debuglevel(0) {};
-  void addWaypoint(std::unique_ptr<Waypoint>& waypoint);
-  void addRoute(std::unique_ptr<WaypointList>& route);
-  void addTrack(std::unique_ptr<WaypointList>& route);
+  QString intern(const QString& name);
+  // capacity hint for count more names
+  void reserve(size_t count);
+  qsizetype size() const;
+private:
+  QSet<QString> names;
+};
 
-  const std::list<std::unique_ptr<Waypoint>>& getWaypoints() const;
-  const std::list<std::unique_ptr<WaypointList>>& getRoutes() const;
-  const std::list<std::unique_ptr<WaypointList>>& getTracks() const;
+// Notified by Geodata when a reader has added a waypoint, route or
+// track. The reader does not modify the object afterwards, so it can
+// be processed on another thread while reading continues.
+class GeodataObserver
+{
+public:
+  virtual ~GeodataObserver() = default;
+  virtual void waypointAdded(const Waypoint* waypoint) = 0;
+  virtual void routeAdded(const WaypointList* route) = 0;
+  virtual void trackAdded(const WaypointList* track) = 0;
+};
+
+// Waypoints, routes and tracks are stored by value. Adding to a
+// deque keeps the addresses of the existing elements, which the
+// observer relies on while reading continues.
+class Geodata
+{
+public:
+  Geodata() : debuglevel(0), observer(nullptr), open_list(nullptr) {};
+
+  // The waypoint is complete when added
+  Waypoint& emplaceWaypoint(double lat, double lon, const QString& name = QString());
+  void addWaypoint(Waypoint&& waypoint);
+  // Routes and tracks are filled in place between begin and end
+  WaypointList& beginRoute(const QString& name = QString());
+  void endRoute();
+  WaypointList& beginTrack(const QString& name = QString());
+  void endTrack();
+  // Add a list that was built before its kind was known
+  void addRoute(WaypointList&& route);
+  void addTrack(WaypointList&& track);
+  // Capacity hint for the number of objects a reader is about to
+  // add, callers cap counts read from files. The deques have no
+  // capacity, but every object adds up to one name to the pool.
+  void reserve(size_t object_count);
+
+  const std::deque<Waypoint>& getWaypoints() const;
+  const std::deque<WaypointList>& getRoutes() const;
+  const std::deque<WaypointList>& getTracks() const;
+  std::deque<Waypoint>& getWaypoints();
+  std::deque<WaypointList>& getRoutes();
+  std::deque<WaypointList>& getTracks();
 
   std::pair<Waypoint,Waypoint> getBounds() const;
 
   void setDebugLevel(int _debuglevel);
   int getDebugLevel();
+  void setObserver(GeodataObserver* _observer);
+  const NamePool& getNames() const;
 private:
-  std::list<std::unique_ptr<Waypoint>> waypoints;
-  std::list<std::unique_ptr<WaypointList>> routes;
-  std::list<std::unique_ptr<WaypointList>> tracks;
+  void internNames(WaypointList* list);
+  void waypointAdded(Waypoint* waypoint);
+  void routeAdded(WaypointList* route);
+  void trackAdded(WaypointList* track);
+
+  NamePool names;
+  std::deque<Waypoint> waypoints;
+  std::deque<WaypointList> routes;
+  std::deque<WaypointList> tracks;
   int debuglevel;
+  GeodataObserver* observer;
+  // list between begin and end
+  WaypointList* open_list;
 };
 
 #endif
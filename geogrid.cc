@@ -0,0 +1,115 @@
+/*
+
+    Hash grid for finding nearby points
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+
+#include "geogrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cache.h"
+
+static constexpr double kEarthRadius = 6371000.0;
+static constexpr double kMetersPerDegree = kEarthRadius * M_PI / 180.0;
+
+static quint64
+geogrid_key(qint64 row, qint64 column)
+{
+  const qint64 key[2] = {row, column};
+  return ConversionCache::hash(reinterpret_cast<const char*>(key), sizeof(key));
+}
+
+GeoGrid::GeoGrid(double tolerance)
+  : cell(std::max(tolerance, kMinTolerance) / kMetersPerDegree)
+{
+}
+
+double
+GeoGrid::cellWidth(qint64 row) const
+{
+  const double poleward = std::max(std::fabs(row * cell), std::fabs((row + 1) * cell));
+  const double scale = std::cos(std::min(poleward, 90.0) * M_PI / 180.0);
+  return cell / std::max(scale, 1e-6);
+}
+
+quint64
+GeoGrid::key(const Waypoint& point) const
+{
+  const qint64 row = qint64(std::floor(point.latitude / cell));
+  const qint64 column = qint64(std::floor(point.longitude / cellWidth(row)));
+  return geogrid_key(row, column);
+}
+
+void
+GeoGrid::insert(const Waypoint& point, size_t id)
+{
+  cells[key(point)].push_back(id);
+}
+
+void
+GeoGrid::remove(const Waypoint& point, size_t id)
+{
+  auto it = cells.find(key(point));
+  if (it == cells.end()) {
+    return;
+  }
+  auto& ids = it->second;
+  auto pos = std::find(ids.begin(), ids.end(), id);
+  if (pos == ids.end()) {
+    return;
+  }
+  // the order within a cell does not matter
+  *pos = ids.back();
+  ids.pop_back();
+  if (ids.empty()) {
+    cells.erase(it);
+  }
+}
+
+void
+GeoGrid::query(const Waypoint& point, std::vector<size_t>* result) const
+{
+  const qint64 row = qint64(std::floor(point.latitude / cell));
+  // tolerance in longitude on the poleward edge of the rows scanned,
+  // no point within the tolerance is further away
+  const double dlon = std::max(cellWidth(row - 1), cellWidth(row + 1));
+  for (qint64 r = row - 1; r <= row + 1; ++r) {
+    const double width = cellWidth(r);
+    const qint64 first = qint64(std::floor((point.longitude - dlon) / width));
+    const qint64 last = qint64(std::floor((point.longitude + dlon) / width));
+    for (qint64 c = first; c <= last; ++c) {
+      auto it = cells.find(geogrid_key(r, c));
+      if (it != cells.end()) {
+        result->insert(result->end(), it->second.begin(), it->second.end());
+      }
+    }
+  }
+}
+
+double
+GeoGrid::distance(const Waypoint& a, const Waypoint& b)
+{
+  const double mean = (a.latitude + b.latitude) / 2.0 * M_PI / 180.0;
+  const double dlat = a.latitude - b.latitude;
+  const double dlon = (a.longitude - b.longitude) * std::cos(mean);
+  return std::sqrt(dlat * dlat + dlon * dlon) * kMetersPerDegree;
+}
@@ -0,0 +1,70 @@
+/*
+
+    Hash grid for finding nearby points
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+
+#ifndef GEOGRID_H_INCLUDED_
+#define GEOGRID_H_INCLUDED_
+
+#include <QtGlobal>
+
+#include <unordered_map>
+#include <vector>
+
+#include "geodata.h"
+
+// Points hashed into cells about tolerance meters wide. Rows are
+// tolerance high, every row is split into columns at least tolerance
+// wide on its poleward edge, so all points within the tolerance of a
+// location are in the rows next to it and a few columns of each.
+// Coordinates must be finite. Longitude does not wrap at 180 degrees.
+// Smaller tolerances than kMinTolerance use cells of that size, so
+// cell indices stay within range.
+class GeoGrid
+{
+public:
+  explicit GeoGrid(double tolerance);
+
+  void insert(const Waypoint& point, size_t id);
+  // Remove an id inserted before at the same point
+  void remove(const Waypoint& point, size_t id);
+  // Append the ids of the points in the cells around point. This
+  // includes points further away than the tolerance, callers check
+  // the distance.
+  void query(const Waypoint& point, std::vector<size_t>* result) const;
+
+  // distance in meters on the equirectangular projection, precise
+  // enough for the short distances compared here
+  static double distance(const Waypoint& a, const Waypoint& b);
+
+  // smallest cell size in meters
+  static constexpr double kMinTolerance = 0.001;
+private:
+  double cellWidth(qint64 row) const;
+  quint64 key(const Waypoint& point) const;
+
+  // cell height in degrees
+  double cell;
+  // cells with the same hash share an entry
+  std::unordered_map<quint64, std::vector<size_t>> cells;
+};
+
+#endif
@@ -0,0 +1,182 @@
+/*
+
+    Support for GeoJSON writing
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+ */
+
+#include <QByteArray>
+
+#include <algorithm>
+#include <cmath>
+
+#include "geojson.h"
+#include "jsonwrite.h"
+
+// write the buffer to the device when it gets larger than this
+static const qsizetype kFlushSize = 64 * 1024;
+
+// Points without a finite position are left out of the geometries
+static bool
+geojson_finite(const Waypoint& waypoint)
+{
+  return std::isfinite(waypoint.latitude) && std::isfinite(waypoint.longitude);
+}
+
+static void
+geojson_append_position(QByteArray& out, const Waypoint* waypoint, int coord_digits, int ele_digits)
+{
+  out += '[';
+  jsonwrite_number(out, waypoint->longitude, coord_digits);
+  out += ',';
+  jsonwrite_number(out, waypoint->latitude, coord_digits);
+  if (std::isfinite(waypoint->elevation)) {
+    out += ',';
+    jsonwrite_number(out, waypoint->elevation, ele_digits);
+  }
+  out += ']';
+}
+
+void
+GeoJsonFormat::writeFeature(QIODevice* io, const QString& name, const WaypointList* waypoints, bool first)
+{
+  if (!first) {
+    buffer += ",\n";
+  }
+  buffer += "{\"type\":\"Feature\",\"properties\":{";
+  if (! name.isEmpty()) {
+    buffer += "\"name\":";
+    jsonwrite_string(buffer, name);
+  }
+  buffer += "},\"geometry\":";
+
+  const auto& points = waypoints->getWaypoints();
+  const size_t finite = std::count_if(points.begin(), points.end(), geojson_finite);
+  if (finite == 0) {
+    buffer += "null";
+  } else if (finite == 1) {
+    buffer += "{\"type\":\"Point\",\"coordinates\":";
+    geojson_append_position(buffer, &*std::find_if(points.begin(), points.end(), geojson_finite), coord_digits, ele_digits);
+    buffer += '}';
+  } else {
+    buffer += "{\"type\":\"LineString\",\"coordinates\":[";
+    bool first_point = true;
+    for (auto&& waypoint : points) {
+      if (!geojson_finite(waypoint)) {
+        continue;
+      }
+      if (!first_point) {
+        buffer += ',';
+      }
+      first_point = false;
+      geojson_append_position(buffer, &waypoint, coord_digits, ele_digits);
+      if (buffer.size() >= kFlushSize) {
+        io->write(buffer);
+        buffer.resize(0);
+      }
+    }
+    buffer += ']';
+    buffer += '}';
+  }
+  buffer += '}';
+
+  if (buffer.size() >= kFlushSize) {
+    io->write(buffer);
+    buffer.resize(0);
+  }
+}
+
+void
+GeoJsonFormat::write(QIODevice* io, const Geodata* geodata)
+{
+  buffer.resize(0);
+  buffer.reserve(kFlushSize + 4096);
+  buffer += "{\"type\":\"FeatureCollection\",";
+
+  if (! geodata->getRoutes().empty() || ! geodata->getTracks().empty() || ! geodata->getWaypoints().empty()) {
+    auto bounds = geodata->getBounds();
+    // no bbox if a point is infinite or none is finite
+    if (geojson_finite(bounds.first) && geojson_finite(bounds.second) &&
+        bounds.first.latitude <= bounds.second.latitude) {
+      buffer += "\"bbox\":[";
+    buffer += "\"bbox\":[";
+      jsonwrite_number(buffer, bounds.first.longitude, coord_digits);
+      buffer += ',';
+      jsonwrite_number(buffer, bounds.first.latitude, coord_digits);
+      buffer += ',';
+      jsonwrite_number(buffer, bounds.second.longitude, coord_digits);
+      buffer += ',';
+      jsonwrite_number(buffer, bounds.second.latitude, coord_digits);
+      buffer += "],";
+    }
+  }
+  buffer += "\"features\":[\n";
+
+  bool first = true;
+  for (auto&& waypoint : std::as_const(geodata->getWaypoints())) {
+    if (!first) {
+      buffer += ",\n";
+    }
+    first = false;
+    buffer += "{\"type\":\"Feature\",\"properties\":{";
+    if (! waypoint.name.isEmpty()) {
+      buffer += "\"name\":";
+      jsonwrite_string(buffer, waypoint.name);
+    }
+    if (geojson_finite(waypoint)) {
+      buffer += "},\"geometry\":{\"type\":\"Point\",\"coordinates\":";
+      geojson_append_position(buffer, &waypoint, coord_digits, ele_digits);
+      buffer += "}}";
+    } else {
+      buffer += "},\"geometry\":null}";
+    }
+    if (buffer.size() >= kFlushSize) {
+      io->write(buffer);
+      buffer.resize(0);
+    }
+  }
+
+  for (auto&& route : std::as_const(geodata->getRoutes())) {
+    writeFeature(io, route.name, &route, first);
+    first = false;
+  }
+
+  for (auto&& track : std::as_const(geodata->getTracks())) {
+    writeFeature(io, track.name, &track, first);
+    first = false;
+  }
+
+  buffer += "\n]}\n";
+  io->write(buffer);
+  buffer.resize(0);
+}
+
+void GeoJsonFormat::setCoordinatePrecision(int digits)
+{
+  coord_digits = digits;
+}
+
+void GeoJsonFormat::setElevationPrecision(int digits)
+{
+  ele_digits = digits;
+}
+
+const QString GeoJsonFormat::getName()
+{
+  return "geojson";
+}
@@ -0,0 +1,55 @@
+/*
+
+    Support for GeoJSON writing
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef GEOJSON_H_INCLUDED_
+#define GEOJSON_H_INCLUDED_
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include "format.h"
+#include "geodata.h"
+
+// Streaming GeoJSON FeatureCollection writer. Waypoints are written
+// as Points, routes and tracks as LineStrings, one feature per line.
+// Numbers use the given precision with trailing zeros removed.
+class GeoJsonFormat : public Format
+{
+public:
+  GeoJsonFormat() : coord_digits(kDefaultDigits), ele_digits(kDefaultDigits) {};
+
+  void write(QIODevice* io, const Geodata* geodata) override;
+  void setCoordinatePrecision(int digits);
+  void setElevationPrecision(int digits);
+  virtual const QString getName() override;
+
+  static const int kDefaultDigits = 9;
+private:
+  void writeFeature(QIODevice* io, const QString& name, const WaypointList* waypoints, bool first);
+
+  int coord_digits;
+  int ele_digits;
+  // output buffer kept across calls to avoid reallocation
+  QByteArray buffer;
+};
+
+#endif
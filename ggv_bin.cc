@@ -26,9 +26,15 @@
 #include <QDebug>
 #include <QIODevice>
 
-#include <memory>
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "ggv_bin.h"
+#include "trace.h"
 
 /***************************************************************************
  *           local helper functions                                        *
@@ -37,13 +43,89 @@
 static int
 ggv_bin_debug_level(const int* update = nullptr)
 {
-  static int debug_level = 0;
+  // set by read() on the thread it runs on, files are read
+  // concurrently when merging
+  static thread_local int debug_level = 0;
   if (update) {
     debug_level = *update;
   }
   return debug_level;
 }
 
+// Whitespace as defined by QChar::isSpace() for Latin-1
+static inline bool
+ggv_bin_is_space(uchar c)
+{
+  return c == 0x20 || (c >= 0x09 && c <= 0x0d) || c == 0x85 || c == 0xa0;
+}
+
+// Same result as QString::fromLatin1(data).simplified() for a NUL
+// terminated string, but in one pass without intermediate strings:
+// the text ends at the first NUL or after len bytes, leading and
+// trailing whitespace is dropped and inner runs of whitespace become
+// a single space. Blocks of 16 printable ASCII characters, which
+// make up most labels, are widened with SSE2.
+static QString
+ggv_bin_decode_text(const char* data, qsizetype len)
+{
+  const char* nul = static_cast<const char*>(memchr(data, '\0', len));
+  if (nul) {
+    len = nul - data;
+  }
+  if (len == 0) {
+    return QString();
+  }
+
+  QString res(len, Qt::Uninitialized);
+  char16_t* out = reinterpret_cast<char16_t*>(res.data());
+  const auto* in = reinterpret_cast<const uchar*>(data);
+  qsizetype n = 0;
+  qsizetype i = 0;
+  bool space = false;
+
+#ifdef __SSE2__
+  const __m128i kSpace = _mm_set1_epi8(0x20);
+  const __m128i kZero = _mm_setzero_si128();
+  while (i + 16 <= len) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    // signed compare: 0x21..0x7f are printable ASCII, bytes >= 0x80
+    // are negative and handled by the scalar loop
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(chunk, kSpace)) != 0xffff) {
+      break;
+    }
+    if (space) {
+      out[n++] = u' ';
+      space = false;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n), _mm_unpacklo_epi8(chunk, kZero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n + 8), _mm_unpackhi_epi8(chunk, kZero));
+    n += 16;
+    i += 16;
+  }
+#endif
+
+  for (; i < len; ++i) {
+    const uchar c = in[i];
+    if (ggv_bin_is_space(c)) {
+      space = n > 0;
+    } else {
+      if (space) {
+        out[n++] = u' ';
+        space = false;
+      }
+      out[n++] = c;
+    }
+  }
+  res.truncate(n);
+  return res;
+}
+
+static QString
+ggv_bin_decode_text(const QByteArray& buf)
+{
+  return ggv_bin_decode_text(buf.constData(), buf.size());
+}
+
 static void
 ggv_bin_read_bytes(QDataStream& stream, QByteArray& buf, int len, const char* descr)
 {
@@ -62,6 +144,20 @@ ggv_bin_read_bytes(QDataStream& stream, QByteArray& buf, int len, const char* de
   }
 }
 
+// Counts read from the file are only used as capacity hints up to
+// the number of items of min_size bytes that fit into the rest of
+// the file, so corrupt counts do not cause large allocations
+static size_t
+ggv_bin_capacity(QDataStream& stream, quint64 count, qint64 min_size)
+{
+  const QIODevice* device = stream.device();
+  const qint64 remaining = device->size() - device->pos();
+  if (remaining <= 0) {
+    return 0;
+  }
+  return static_cast<size_t>(std::min<quint64>(count, remaining / min_size));
+}
+
 static quint16
 ggv_bin_read16(QDataStream& stream, const char* descr)
 {
@@ -116,11 +212,10 @@ ggv_bin_read_text16(QDataStream& stream, QByteArray& buf, const char* descr)
 {
   quint16 len = ggv_bin_read16(stream, descr);
   ggv_bin_read_bytes(stream, buf, len, descr);
-  buf.append('\0');
   if (ggv_bin_debug_level() > 1) {
     qDebug().noquote()
         << "bin: text ="
-        << QString::fromLatin1(buf.constData()).simplified();
+        << ggv_bin_decode_text(buf);
   }
 }
 
@@ -141,11 +236,10 @@ ggv_bin_read_text32(QDataStream& stream, QByteArray& buf, const char* descr)
     exit(1);
   }
   ggv_bin_read_bytes(stream, buf, static_cast<int>(len), descr);
-  buf.append('\0');
   if (ggv_bin_debug_level() > 1) {
     qDebug().noquote()
         << "bin: text ="
-        << QString::fromLatin1(buf.constData()).simplified();
+        << ggv_bin_decode_text(buf);
   }
 }
 
@@ -170,6 +264,7 @@ ggv_bin_read_double(QDataStream& stream, const char* descr)
 static void
 ggv_bin_read_v2(QDataStream& stream, Geodata* geodata)
 {
+  TraceSpan span("reader", "v2 records");
   QByteArray buf;
   QString track_name;
   QString waypt_name;
@@ -203,46 +298,44 @@ ggv_bin_read_v2(QDataStream& stream, Geodata* geodata)
 
     if (entry_subtype != 1) {
       ggv_bin_read_text32(stream, buf, "text len");
-      track_name = QString::fromLatin1(buf.constData()).simplified();
+      track_name = ggv_bin_decode_text(buf);
     }
 
 
     switch (entry_type) {
     case 0x02: {
       // text
-      auto wpt = std::make_unique<Waypoint>();
+      Waypoint wpt;
       ggv_bin_read16(stream, "text color");
       ggv_bin_read16(stream, "text size");
       ggv_bin_read16(stream, "text trans");
       ggv_bin_read16(stream, "text font");
       ggv_bin_read16(stream, "text angle");
-      wpt->longitude = ggv_bin_read_double(stream, "text lon");
-      wpt->latitude = ggv_bin_read_double(stream, "text lat");
+      wpt.longitude = ggv_bin_read_double(stream, "text lon");
+      wpt.latitude = ggv_bin_read_double(stream, "text lat");
       ggv_bin_read_text16(stream, buf, "text label");
-      wpt->name = QString::fromLatin1(buf.constData()).simplified();
-      geodata->addWaypoint(wpt);
+      wpt.name = ggv_bin_decode_text(buf);
+      geodata->addWaypoint(std::move(wpt));
     }
     break;
     case 0x03:
     // line
     case 0x04: {
       // area
-      auto ggv_bin_track = std::make_unique<WaypointList>();
       ggv_bin_read16(stream, "line color");
       ggv_bin_read16(stream, "line width");
       ggv_bin_read16(stream, "line type");
       line_points = ggv_bin_read16(stream, "line points");
-      if (! track_name.isEmpty()) {
-        ggv_bin_track->name = track_name;
-      }
+      WaypointList& ggv_bin_track = geodata->beginTrack(track_name);
+      // lon, lat
+      ggv_bin_track.reserve(ggv_bin_capacity(stream, line_points, 16));
 
       for (int i = 1; i <= line_points; i++) {
-        auto wpt = std::make_unique<Waypoint>();
-        wpt->longitude = ggv_bin_read_double(stream, "line lon");
-        wpt->latitude = ggv_bin_read_double(stream, "line lat");
-        ggv_bin_track->addWaypoint(wpt);
+        double lon = ggv_bin_read_double(stream, "line lon");
+        double lat = ggv_bin_read_double(stream, "line lat");
+        ggv_bin_track.emplacePoint(lat, lon);
       }
-      geodata->addTrack(ggv_bin_track);
+      geodata->endTrack();
     }
     break;
     case 0x05:
@@ -342,7 +435,7 @@ ggv_bin_read_v34_common(QDataStream& stream)
   ggv_bin_read16(stream, "entry zoom");
   ggv_bin_read16(stream, "entry prop10");
   ggv_bin_read_text16(stream, buf, "entry txt");
-  QString res = QString::fromLatin1(buf.constData()).simplified();
+  QString res = ggv_bin_decode_text(buf);
   quint16 type1 = ggv_bin_read16(stream, "entry type1");
   if (type1 != 1) {
     ggv_bin_read_text32(stream, buf, "entry object");
@@ -373,7 +466,7 @@ ggv_bin_read_v34_record(QDataStream& stream, Geodata* geodata)
   switch (entry_type) {
   case 0x02: {
     // text
-    auto wpt = std::make_unique<Waypoint>();
+    Waypoint wpt;
     ggv_bin_read16(stream, "text prop1");
     ggv_bin_read32(stream, "text prop2");
     ggv_bin_read16(stream, "text prop3");
@@ -382,12 +475,12 @@ ggv_bin_read_v34_record(QDataStream& stream, Geodata* geodata)
     ggv_bin_read16(stream, "text angle");
     ggv_bin_read16(stream, "text size");
     ggv_bin_read16(stream, "text area");
-    wpt->longitude = ggv_bin_read_double(stream, "text lon");
-    wpt->latitude = ggv_bin_read_double(stream, "text lat");
+    wpt.longitude = ggv_bin_read_double(stream, "text lon");
+    wpt.latitude = ggv_bin_read_double(stream, "text lat");
     ggv_bin_read_double(stream, "text unk");
     ggv_bin_read_text16(stream, buf, "text label");
-    wpt->name = QString::fromLatin1(buf.constData()).simplified();
-    geodata->addWaypoint(wpt);
+    wpt.name = ggv_bin_decode_text(buf);
+    geodata->addWaypoint(std::move(wpt));
   }
   break;
 
@@ -396,12 +489,6 @@ ggv_bin_read_v34_record(QDataStream& stream, Geodata* geodata)
   // area
   case 0x17: {
     // line
-    auto ggv_bin_track = std::make_unique<WaypointList>();
-
-    if (! label.isEmpty()) {
-      ggv_bin_track->name = label;
-    }
-
     ggv_bin_read16(stream, "line prop1");
     ggv_bin_read32(stream, "line prop2");
     ggv_bin_read16(stream, "line prop3");
@@ -413,16 +500,18 @@ ggv_bin_read_v34_record(QDataStream& stream, Geodata* geodata)
       // found in example.ovl generated by Geogrid-Viewer 1.0
       ggv_bin_read16(stream, "line pad");
     }
+    WaypointList& ggv_bin_track = geodata->beginTrack(label);
+    // lon, lat, unknown
+    ggv_bin_track.reserve(ggv_bin_capacity(stream, line_points, 24));
 
     for (int i=1; i <= line_points; i++) {
-      auto wpt = std::make_unique<Waypoint>();
-      wpt->longitude = ggv_bin_read_double(stream, "line lon");
-      wpt->latitude = ggv_bin_read_double(stream, "line lat");
+      double lon = ggv_bin_read_double(stream, "line lon");
+      double lat = ggv_bin_read_double(stream, "line lat");
       ggv_bin_read_double(stream, "line unk");
-      ggv_bin_track->addWaypoint(wpt);
+      ggv_bin_track.emplacePoint(lat, lon);
     }
 
-    geodata->addTrack(ggv_bin_track);
+    geodata->endTrack();
   }
   break;
 
@@ -486,9 +575,13 @@ ggv_bin_read_v34(QDataStream& stream, Geodata* geodata)
   quint32 record_count = 0;
 
   while (!stream.atEnd()) {
-    ggv_bin_read_v34_header(stream, label_count, record_count);
+    {
+      TraceSpan span("reader", "v34 header");
+      ggv_bin_read_v34_header(stream, label_count, record_count);
+    }
 
     if (label_count && !stream.atEnd()) {
+      TraceSpan span("reader", "v34 labels", QString::number(label_count));
       if (ggv_bin_debug_level() > 1) {
         qDebug().noquote()
             << QString("-----labels------------------------- 0x%1x")
@@ -500,6 +593,10 @@ ggv_bin_read_v34(QDataStream& stream, Geodata* geodata)
     }
 
     if (record_count && !stream.atEnd()) {
+      TraceSpan span("reader", "v34 records", QString::number(record_count));
+      // records are texts (waypoints) or lines (tracks), the smallest
+      // record has 28 bytes
+      geodata->reserve(ggv_bin_capacity(stream, record_count, 28));
       if (ggv_bin_debug_level() > 1) {
         qDebug().noquote()
             << QString("-----records------------------------ 0x%1")
@@ -23,11 +23,20 @@
 
 #include <QByteArray>
 #include <QDebug>
+#include <QHash>
 #include <QSettings>
 #include <QString>
 #include <QTemporaryFile>
+#include <QVariant>
+
+#include <algorithm>
+#include <charconv>
+#include <list>
+#include <memory>
 
 #include "ggv_ovl.h"
+#include "numparse.h"
+#include "trace.h"
 
 enum OVL_SYMBOL_TYP {
   OVL_SYMBOL_BITMAP = 1,
@@ -48,6 +57,232 @@ enum OVL_SYMBOL_TYP {
 		# "art":   line-style
  */
 
+/***************************************************************************
+ *           INI file access                                               *
+ ***************************************************************************/
+
+// The overlay files written by Geogrid-Viewer only use a small part
+// of the QSettings INI syntax. The file is scanned once and the
+// values are referenced in the buffer, so numbers are parsed without
+// creating strings. Values QSettings would treat specially (quotes,
+// lists, escapes, variants, non-ASCII text) are read with QSettings,
+// and so is the whole file if it uses escapes or percent encoding.
+class OvlIniFile
+{
+public:
+  explicit OvlIniFile(const QByteArray& _data);
+
+  int intValue(const QByteArray& key, int defval);
+  // false if the value is undefined or empty
+  bool doubleValue(const QByteArray& key, double* value);
+  QString stringValue(const QByteArray& key);
+private:
+  struct Value {
+    qsizetype offset;
+    qsizetype len;
+    bool plain;
+  };
+
+  const Value* lookup(const QByteArray& key) const;
+  QVariant fallback(const QByteArray& key, const QVariant& defval);
+  void parse();
+
+  QByteArray data;
+  QHash<QByteArray, Value> values;
+  bool use_settings;
+  std::unique_ptr<QTemporaryFile> tempfile;
+  std::unique_ptr<QSettings> settings;
+};
+
+static bool
+ggv_ovl_is_blank(char c)
+{
+  return c == ' ' || c == '\t';
+}
+
+// a value QSettings returns unchanged as string
+static bool
+ggv_ovl_is_plain(const char* value, qsizetype len)
+{
+  if (len > 0 && value[0] == '@') {
+    return false;
+  }
+  for (qsizetype i = 0; i < len; ++i) {
+    const char c = value[i];
+    if (c < 0x20 || c > 0x7e || c == '"' || c == ',' || c == ';' || c == '#') {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Counts read from the file are only used as capacity hints up to
+// a limit given by the file size. Every symbol and every point takes
+// at least two lines with 16 bytes together.
+static size_t
+ggv_ovl_capacity(const QByteArray& data, int count)
+{
+  if (count <= 0) {
+    return 0;
+  }
+  return std::min<size_t>(count, data.size() / 16);
+}
+
+OvlIniFile::OvlIniFile(const QByteArray& _data) : data(_data), use_settings(false)
+{
+  if (data.contains('\\') || data.contains('%')) {
+    use_settings = true;
+  } else {
+    parse();
+  }
+}
+
+void
+OvlIniFile::parse()
+{
+  const char* buf = data.constData();
+  const qsizetype size = data.size();
+  qsizetype pos = data.startsWith("\xef\xbb\xbf") ? 3 : 0;
+  QByteArray section;
+  QByteArray key;
+
+  while (pos < size) {
+    qsizetype begin = pos;
+    while (pos < size && buf[pos] != '\n' && buf[pos] != '\r') {
+      pos++;
+    }
+    qsizetype end = pos;
+    pos++;
+
+    while (begin < end && ggv_ovl_is_blank(buf[begin])) {
+      begin++;
+    }
+    while (end > begin && ggv_ovl_is_blank(buf[end - 1])) {
+      end--;
+    }
+    if (begin == end || buf[begin] == ';' || buf[begin] == '#') {
+      continue;
+    }
+    if (buf[begin] == '[') {
+      qsizetype close = begin + 1;
+      while (close < end && buf[close] != ']') {
+        close++;
+      }
+      section = QByteArray(buf + begin + 1, close - begin - 1).trimmed();
+      continue;
+    }
+    qsizetype eq = begin;
+    while (eq < end && buf[eq] != '=') {
+      eq++;
+    }
+    if (eq == end) {
+      use_settings = true;
+      return;
+    }
+    qsizetype key_end = eq;
+    while (key_end > begin && ggv_ovl_is_blank(buf[key_end - 1])) {
+      key_end--;
+    }
+    qsizetype value_begin = eq + 1;
+    while (value_begin < end && ggv_ovl_is_blank(buf[value_begin])) {
+      value_begin++;
+    }
+
+    key = section;
+    key += '/';
+    key.append(buf + begin, key_end - begin);
+    Value value{value_begin, end - value_begin, ggv_ovl_is_plain(buf + value_begin, end - value_begin)};
+    auto it = values.find(key);
+    if (it != values.end()) {
+      // which definition wins is up to QSettings
+      it->plain = false;
+    } else {
+      values.insert(key, value);
+    }
+  }
+}
+
+const OvlIniFile::Value*
+OvlIniFile::lookup(const QByteArray& key) const
+{
+  auto it = values.constFind(key);
+  return it != values.constEnd() ? &it.value() : nullptr;
+}
+
+QVariant
+OvlIniFile::fallback(const QByteArray& key, const QVariant& defval)
+{
+  if (!settings) {
+    TraceSpan span("reader", "ini settings");
+    // QSettings does not handle QIODevice. Therefore the data is
+    // written to a tempfile.
+    tempfile = std::make_unique<QTemporaryFile>();
+    tempfile->open();
+    tempfile->write(data);
+    tempfile->close();
+    settings = std::make_unique<QSettings>(tempfile->fileName(), QSettings::IniFormat);
+  }
+  return settings->value(QString::fromLatin1(key), defval);
+}
+
+int
+OvlIniFile::intValue(const QByteArray& key, int defval)
+{
+  const Value* value = use_settings ? nullptr : lookup(key);
+  if (!value) {
+    return use_settings ? fallback(key, defval).toInt() : defval;
+  }
+  if (!value->plain) {
+    return fallback(key, defval).toInt();
+  }
+  const char* begin = data.constData() + value->offset;
+  int res = 0;
+  if (numparse_int(begin, begin + value->len, &res)) {
+    return res;
+  }
+  return QString::fromLatin1(begin, value->len).toInt();
+}
+
+bool
+OvlIniFile::doubleValue(const QByteArray& key, double* res)
+{
+  const Value* value = use_settings ? nullptr : lookup(key);
+  if (use_settings || (value && !value->plain)) {
+    QString text = fallback(key, "").toString();
+    if (text.isEmpty()) {
+      return false;
+    }
+    *res = text.toDouble();
+    return true;
+  }
+  if (!value || value->len == 0) {
+    return false;
+  }
+  const char* begin = data.constData() + value->offset;
+  if (!numparse_double(begin, begin + value->len, res)) {
+    *res = QString::fromLatin1(begin, value->len).toDouble();
+  }
+  return true;
+}
+
+QString
+OvlIniFile::stringValue(const QByteArray& key)
+{
+  const Value* value = use_settings ? nullptr : lookup(key);
+  if (use_settings || (value && !value->plain)) {
+    return fallback(key, "").toString();
+  }
+  if (!value) {
+    return QString();
+  }
+  return QString::fromLatin1(data.constData() + value->offset, value->len);
+}
+
+/***************************************************************************
+ *              entry points called by ggvtogpx main process               *
+ ***************************************************************************/
+
+
 bool
 GgvOvlFormat::probe(QIODevice* io)
 {
@@ -71,30 +306,46 @@ void
 GgvOvlFormat::read(QIODevice* io, Geodata* geodata)
 {
   io->reset();
-  // QSettings does not handle QIODevice. Therefore we write
-  // the data to a tempfile here to be able to keep the nice
-  // generic interface with QIODevice
-  QTemporaryFile tempfile;
-  tempfile.open();
-  tempfile.write(io->readAll());
-  tempfile.close();
+  readBuffer(io->readAll(), geodata);
+}
 
-  QSettings inifile(tempfile.fileName(), QSettings::IniFormat);
+void
+GgvOvlFormat::readBuffer(const QByteArray& data, Geodata* geodata)
+{
+  auto parse_span = std::make_unique<TraceSpan>("reader", "ini parse");
+  OvlIniFile inifile(data);
 
   int route_count = 0;
   int track_count = 0;
   int waypoint_count = 0;
-  int symbols = inifile.value("Overlay/Symbols", 0).toInt();
+  int symbols = inifile.intValue("Overlay/Symbols", 0);
+  parse_span.reset();
+  TraceSpan convert_span("reader", "ini convert");
   if (getDebugLevel() > 1) {
     qDebug() << "ggv_ovl::read() symbols:" << symbols;
   }
+  // symbols can be waypoints, routes or tracks
+  geodata->reserve(ggv_ovl_capacity(data, symbols));
 
-  QString latitude;
-  QString longitude;
+  // keys are built in place to avoid a string per coordinate
+  QByteArray section;
+  QByteArray key;
+  auto make_key = [&section, &key](const char* name, int index = -1) -> const QByteArray& {
+    key = section;
+    key += '/';
+    key += name;
+    if (index >= 0) {
+      char buf[16];
+      auto res = std::to_chars(buf, buf + sizeof(buf), index);
+      key.append(buf, res.ptr - buf);
+    }
+    return key;
+  };
 
   for (int i = 1; i <= symbols; ++i) {
     QString symbol = QString("Symbol %1").arg(i);
-    int type = inifile.value(symbol + "/Typ", 0).toInt();
+    section = symbol.toLatin1();
+    int type = inifile.intValue(make_key("Typ"), 0);
     if (getDebugLevel() > 1) {
       qDebug() << "ggv_ovl::read() symbol:" << symbol;
       qDebug() << "ggv_ovl::read() type:" << type;
@@ -108,7 +359,7 @@ GgvOvlFormat::read(QIODevice* io, Geodata* geodata)
     switch (type) {
     case OVL_SYMBOL_LINE:
     case OVL_SYMBOL_POLYGON: {
-      int group = inifile.value(symbol + "/Group", -1).toInt();
+      int group = inifile.intValue(make_key("Group"), -1);
       if (getDebugLevel() > 1) {
         qDebug() << "ggv_ovl::read() group:" << group;
       }
@@ -118,7 +369,7 @@ GgvOvlFormat::read(QIODevice* io, Geodata* geodata)
         exit(1);
       }
 
-      int points = inifile.value(symbol + "/Punkte", -1).toInt();
+      int points = inifile.intValue(make_key("Punkte"), -1);
       if (getDebugLevel() > 1) {
         qDebug() << "ggv_ovl::read() points:" << points;
       }
@@ -128,44 +379,38 @@ GgvOvlFormat::read(QIODevice* io, Geodata* geodata)
         exit(1);
       }
 
-      auto waypoint_list = std::make_unique<WaypointList>();
+      // the list is filled in place, its name follows the points
+      WaypointList& waypoint_list = group > 1 ? geodata->beginRoute() : geodata->beginTrack();
+      waypoint_list.reserve(ggv_ovl_capacity(data, points));
       for (int j = 0; j < points; ++j) {
-        latitude = inifile.value(symbol + "/YKoord" + QString::number(j), "").toString();
-        if (latitude.isEmpty()) {
+        Waypoint& waypoint = waypoint_list.emplacePoint(NAN, NAN);
+        if (!inifile.doubleValue(make_key("YKoord", j), &waypoint.latitude)) {
           qCritical().noquote()
               << QStringLiteral("ovl: undefined coordinate: %1/YKoord%2").arg(symbol).arg(j) ;
           exit(1);
         }
-        longitude = inifile.value(symbol + "/XKoord" + QString::number(j), "").toString();
-        if (longitude.isEmpty()) {
-          if (latitude.isEmpty()) {
-            qCritical().noquote()
-                << QStringLiteral("ovl: undefined coordinate: %1/XKoord%2").arg(symbol).arg(j) ;
-            exit(1);
-          }
+        // an undefined longitude has always been read as 0
+        if (!inifile.doubleValue(make_key("XKoord", j), &waypoint.longitude)) {
+          waypoint.longitude = 0.0;
         }
-        auto waypoint = std::make_unique<Waypoint>();
-        waypoint->latitude = latitude.toDouble();
-        waypoint->longitude = longitude.toDouble();
         if (group > 1) {
           waypoint_count++;
-          waypoint->name = QString("RPT") + QString::number(waypoint_count).rightJustified(3, '0');
+          waypoint.name = QString("RPT") + QString::number(waypoint_count).rightJustified(3, '0');
         }
-        waypoint_list->addWaypoint(waypoint);
       }
 
-      waypoint_list->name = inifile.value(symbol + "/Text", "").toString();
-      if (waypoint_list->name.isEmpty()) {
+      waypoint_list.name = inifile.stringValue(make_key("Text"));
+      if (waypoint_list.name.isEmpty()) {
         if (group > 1) {
-          waypoint_list->name = QString("Route %1").arg(++route_count);
+          waypoint_list.name = QString("Route %1").arg(++route_count);
         } else {
-          waypoint_list->name = QString("Track %1").arg(++track_count);
+          waypoint_list.name = QString("Track %1").arg(++track_count);
         }
       }
       if (group > 1) {
-        geodata->addRoute(waypoint_list);
+        geodata->endRoute();
       } else {
-        geodata->addTrack(waypoint_list);
+        geodata->endTrack();
       }
     }
     break;
@@ -174,26 +419,20 @@ GgvOvlFormat::read(QIODevice* io, Geodata* geodata)
     case OVL_SYMBOL_RECTANGLE:
     case OVL_SYMBOL_CIRCLE:
     case OVL_SYMBOL_TRIANGLE: {
-      latitude = inifile.value(symbol + "/YKoord", "").toString();
-      if (latitude.isEmpty()) {
+      double lat;
+      double lon;
+      if (!inifile.doubleValue(make_key("YKoord"), &lat)) {
         qCritical().noquote()
             << QStringLiteral("ovl: undefined coordinate: %1/YKoord").arg(symbol);
         exit(1);
       }
-      longitude = inifile.value(symbol + "/XKoord", "").toString();
-      if (longitude.isEmpty()) {
+      if (!inifile.doubleValue(make_key("XKoord"), &lon)) {
         qCritical().noquote()
             << QStringLiteral("ovl: undefined coordinate: %1/XKoord").arg(symbol);
         exit(1);
       }
-      auto waypoint = std::make_unique<Waypoint>();
-      waypoint->latitude = latitude.toDouble();
-      waypoint->longitude = longitude.toDouble();
-      waypoint->name = inifile.value(symbol + "/Text", "").toString();
-      if (waypoint->name.isEmpty()) {
-        waypoint->name = symbol;
-      }
-      geodata->addWaypoint(waypoint);
+      QString name = inifile.stringValue(make_key("Text"));
+      geodata->emplaceWaypoint(lat, lon, name.isEmpty() ? symbol : name);
     }
     break;
 
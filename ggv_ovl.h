@@ -22,6 +22,7 @@
 #ifndef GGV_OVL_H_INCLUDED_
 #define GGV_OVL_H_INCLUDED_
 
+#include <QByteArray>
 #include <QIODevice>
 #include <QString>
 
@@ -34,6 +35,7 @@ public:
   GgvOvlFormat() {};
   bool probe(QIODevice* io) override;
   void read(QIODevice* io, Geodata* geodata) override;
+  void readBuffer(const QByteArray& data, Geodata* geodata) override;
   const QString getName() override;
 };
 
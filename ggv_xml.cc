@@ -26,9 +26,14 @@
 #include <QLatin1String>
 #include <QDomDocument>
 
+#include <memory>
+#include <utility>
+
 #include <zip.h>
 
 #include "ggv_xml.h"
+#include "numparse.h"
+#include "trace.h"
 
 
 /***************************************************************************
@@ -39,17 +44,35 @@
 static int
 ggv_xml_debug_level(const int* update = nullptr)
 {
-  static int debug_level = 0;
+  // set by read() on the thread it runs on, files are read
+  // concurrently when merging
+  static thread_local int debug_level = 0;
   if (update) {
     debug_level = *update;
   }
   return debug_level;
 }
 
-static std::unique_ptr<WaypointList>
+static double
+ggv_xml_to_double(const QString& text)
+{
+  double value = 0.0;
+  if (numparse_double(text, &value)) {
+    return value;
+  }
+  return text.toDouble();
+}
+
+static WaypointList
 ggv_xml_parse_attributelist(QDomNode& attributelist)
 {
-  auto waypoint_list = std::make_unique<WaypointList>();
+  static const QString kAttrX = QStringLiteral("x");
+  static const QString kAttrY = QStringLiteral("y");
+  static const QString kAttrZ = QStringLiteral("z");
+  // elevation of points without height
+  static const double kNoElevation = -32768.0;
+
+  WaypointList waypoint_list;
   for (QDomNode attribute = attributelist.firstChildElement("attribute"); !attribute.isNull(); attribute = attribute.nextSibling()) {
     QDomElement e = attribute.toElement();
     QString iidname = e.attribute("iidName");
@@ -62,7 +85,7 @@ ggv_xml_parse_attributelist(QDomNode& attributelist)
         continue;
       }
       if (! text.text().isEmpty()) {
-        waypoint_list->name = text.text();
+        waypoint_list.name = text.text();
         if (ggv_xml_debug_level() > 1) {
           qDebug().noquote() << "            text:" << text.text();
         }
@@ -72,24 +95,28 @@ ggv_xml_parse_attributelist(QDomNode& attributelist)
       if (coordlist.isNull()) {
         continue;
       }
+      // the DOM is complete, so the count is exact
+      waypoint_list.reserve(waypoint_list.getWaypoints().size() + coordlist.childNodes().count());
       for (QDomNode coord = coordlist.firstChildElement("coord"); !coord.isNull(); coord = coord.nextSibling()) {
         QDomElement coordElement = coord.toElement();
-        if (!coordElement.hasAttribute("x") || !coordElement.hasAttribute("y")) {
+        if (!coordElement.hasAttribute(kAttrX) || !coordElement.hasAttribute(kAttrY)) {
           continue;
         }
-        auto waypoint = std::make_unique<Waypoint>();
-        waypoint->latitude = coordElement.attribute("y").toDouble();
-        waypoint->longitude = coordElement.attribute("x").toDouble();
-        if (coordElement.hasAttribute("z") && coordElement.attribute("z") != "-32768") {
-          waypoint->elevation = coordElement.attribute("z").toDouble();
+        double lat = ggv_xml_to_double(coordElement.attribute(kAttrY));
+        double lon = ggv_xml_to_double(coordElement.attribute(kAttrX));
+        Waypoint& waypoint = waypoint_list.emplacePoint(lat, lon);
+        if (coordElement.hasAttribute(kAttrZ)) {
+          double elevation = ggv_xml_to_double(coordElement.attribute(kAttrZ));
+          if (elevation != kNoElevation) {
+            waypoint.elevation = elevation;
+          }
         }
         if (ggv_xml_debug_level() > 2) {
           qDebug().noquote() << "            coord:"
-                             << waypoint->latitude
-                             << waypoint->longitude
-                             << waypoint->elevation;
+                             << waypoint.latitude
+                             << waypoint.longitude
+                             << waypoint.elevation;
         }
-        waypoint_list->addWaypoint(waypoint);
       }
     }
 
@@ -97,7 +124,7 @@ ggv_xml_parse_attributelist(QDomNode& attributelist)
   }
   if (ggv_xml_debug_level() > 1) {
     qDebug().noquote() << "            coord count:"
-                       << waypoint_list->getWaypoints().size();
+                       << waypoint_list.getWaypoints().size();
   }
   return waypoint_list;
 }
@@ -111,6 +138,9 @@ ggv_xml_parse_document(QDomDocument& xml, Geodata* geodata)
   uint32_t track_count = 0;
   uint32_t text_count = 0;
 
+  // objects are either waypoints or tracks
+  geodata->reserve(objectList.childNodes().count());
+
   for (QDomNode object = objectList.firstChildElement("object"); !object.isNull(); object = object.nextSibling()) {
     if (! object.isElement()) {
       continue;
@@ -151,43 +181,41 @@ ggv_xml_parse_document(QDomDocument& xml, Geodata* geodata)
     }
 
     QDomNode attributelist = object.firstChildElement("attributeList");
-    auto waypoint_list = ggv_xml_parse_attributelist(attributelist);
-    if (waypoint_list && waypoint_list->getWaypoints().size()) {
+    WaypointList waypoint_list = ggv_xml_parse_attributelist(attributelist);
+    if (waypoint_list.getWaypoints().size()) {
       if (clsname == "CLSID_GraphicLine") {
         if (name.isEmpty() || name == "Teilstrecke" || name == "Line") {
-          waypoint_list->name = QString("Track ") + QString::number(++track_count).rightJustified(3, '0');
+          waypoint_list.name = QString("Track ") + QString::number(++track_count).rightJustified(3, '0');
         } else {
-          waypoint_list->name = name;
+          waypoint_list.name = name;
         }
-        geodata->addTrack(waypoint_list);
+        geodata->addTrack(std::move(waypoint_list));
       } else if (clsname == "CLSID_GraphicCircle") {
-        auto waypoint = waypoint_list->extractFirstWaypoint();
-        if (waypoint) {
-          if (name.isEmpty() || name == "Circle") {
-            waypoint->name = QString("RPT") + QString::number(++waypoint_count).rightJustified(3, '0');
-          } else {
-            waypoint->name = name;
-          }
-          geodata->addWaypoint(waypoint);
+        Waypoint waypoint = waypoint_list.extractFirstWaypoint();
+        if (name.isEmpty() || name == "Circle") {
+          waypoint.name = QString("RPT") + QString::number(++waypoint_count).rightJustified(3, '0');
+        } else {
+          waypoint.name = name;
         }
+        geodata->addWaypoint(std::move(waypoint));
       } else if (clsname == "CLSID_GraphicText") {
-        auto waypoint = waypoint_list->extractFirstWaypoint();
-        if (waypoint) {
-          if (waypoint_list->name.isEmpty() || waypoint_list->name == "Text") {
-            waypoint->name = QString("Text %1").arg(++text_count);
-          } else {
-            waypoint->name = waypoint_list->name;
-          }
-          geodata->addWaypoint(waypoint);
+        Waypoint waypoint = waypoint_list.extractFirstWaypoint();
+        if (waypoint_list.name.isEmpty() || waypoint_list.name == "Text") {
+          waypoint.name = QString("Text %1").arg(++text_count);
+        } else {
+          waypoint.name = waypoint_list.name;
         }
+        geodata->addWaypoint(std::move(waypoint));
       }
     }
   }
 }
 
 static int
-ggv_xml_read_zip(QByteArray& buf, Geodata* geodata)
+ggv_xml_read_zip(const QByteArray& buf, Geodata* geodata)
 {
+  auto inflate_span = std::make_unique<TraceSpan>("reader", "zip inflate");
+
   // using a shared pointer to register fini function that frees memory
   // within the non-dynamic zip_error_t
   zip_error_t error_storage;
@@ -196,7 +224,7 @@ ggv_xml_read_zip(QByteArray& buf, Geodata* geodata)
   });
   zip_error_init(error.get());
 
-  std::shared_ptr<zip_source_t> source(zip_source_buffer_create(buf.data(), buf.size(), 0, error.get()), [](zip_source_t* source) {
+  std::shared_ptr<zip_source_t> source(zip_source_buffer_create(buf.constData(), buf.size(), 0, error.get()), [](zip_source_t* source) {
     if (source) {
       zip_source_free(source);
     }
@@ -265,9 +293,17 @@ ggv_xml_read_zip(QByteArray& buf, Geodata* geodata)
     return 1;
   }
 
+  inflate_span.reset();
+
   QDomDocument xml("geogrid50");
-  xml.setContent(filebuf);
-  ggv_xml_parse_document(xml, geodata);
+  {
+    TraceSpan span("reader", "dom build");
+    xml.setContent(filebuf);
+  }
+  {
+    TraceSpan span("reader", "dom parse");
+    ggv_xml_parse_document(xml, geodata);
+  }
   return 0;
 }
 
@@ -306,6 +342,19 @@ GgvXmlFormat::read(QIODevice* io, Geodata* geodata)
   }
 }
 
+// libzip reads the archive from memory anyway, so a loaded file is
+// used without a copy
+void
+GgvXmlFormat::readBuffer(const QByteArray& data, Geodata* geodata)
+{
+  int debug_level = getDebugLevel();
+  ggv_xml_debug_level(&debug_level);
+
+  if (ggv_xml_read_zip(data, geodata)) {
+    exit(1);
+  }
+}
+
 const QString GgvXmlFormat::getName()
 {
   return "ggv_xml";
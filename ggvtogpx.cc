@@ -19,117 +19,734 @@
 
 */
 
+#include <QBuffer>
 #include <QCoreApplication>
 #include <QCommandLineParser>
 #include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QStringList>
+#include <QThread>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <list>
 #include <memory>
+#include <thread>
+#include <vector>
 
+#include "cache.h"
+#include "columnar.h"
+#include "compress.h"
 #include "format.h"
 #include "geodata.h"
+#include "geogrid.h"
+#include "geojson.h"
 #include "ggv_bin.h"
 #include "ggv_ovl.h"
 #include "ggv_xml.h"
 #include "gpx.h"
+#include "ingest.h"
+#include "merge.h"
+#include "parallel.h"
+#include "readahead.h"
+#include "simplify.h"
+#include "spatial.h"
+#include "stats.h"
+#include "stitch.h"
+#include "summary.h"
+#include "trace.h"
+#include "watch.h"
 
-static void process_files(const QString& formatName, const QString& infileName, const QString& outfileName, const QString& creator, bool testmode, int debug_level)
+// An output format and file, "-" is stdout
+struct OutputSpec {
+  QString formatName;
+  QString fileName;
+};
+
+struct ProcessOptions {
+  QString formatName;
+  std::vector<OutputSpec> outputs;
+  QString creator;
+  bool testmode = false;
+  int debug_level = 0;
+  // run read and write several times for benchmarking
+  int repeat = 1;
+  // join tracks with ends closer than this in meters, 0 disables it
+  double stitch = 0.0;
+  // keep only objects inside the box, clip cuts tracks at its edges
+  bool bbox = false;
+  GeoBox box = {0.0, 0.0, 0.0, 0.0};
+  bool clip = false;
+  // Douglas-Peucker tolerance in meters, 0 disables simplification
+  double simplify = 0.0;
+  // distance in meters below which merged waypoints with the same
+  // name are duplicates, 0 removes exact duplicates only
+  double merge_tolerance = 0.0;
+  // GPX shards, a limit of 0 writes a single document
+  GpxSplit split = {GpxSplit::kPoints, 0};
+  // GPX output layout
+  bool compact = false;
+  bool name_copies = true;
+  int coord_digits = GpxFormat::kDefaultDigits;
+  int ele_digits = GpxFormat::kDefaultDigits;
+  // worker threads, 0 is automatic
+  int threads = 0;
+  // overlap reading, decoding and formatting
+  bool pipeline = true;
+  // conversion cache, nullptr if disabled
+  const ConversionCache* cache = nullptr;
+};
+
+struct OutputFile {
+  std::unique_ptr<Format> writer;
+  std::unique_ptr<QFile> file;
+  QString fileName;
+  CompressDevice::Method compression = CompressDevice::None;
+  quint64 cache_key = 0;
+};
+
+static std::unique_ptr<Format> create_writer(const QString& formatName, const ProcessOptions& options)
 {
-  if (debug_level > 2) {
-    qDebug() << "process_files: format =" << formatName << " infile =" << infileName << " outfile =" << outfileName << " creator =" << creator;
+  if (formatName == "gpx") {
+    auto gpx = std::make_unique<GpxFormat>();
+    gpx->setCreator(options.creator);
+    gpx->setTestmode(options.testmode);
+    gpx->setCompact(options.compact);
+    gpx->setNameCopies(options.name_copies);
+    gpx->setCoordinatePrecision(options.coord_digits);
+    gpx->setElevationPrecision(options.ele_digits);
+    gpx->setThreads(options.threads);
+    return gpx;
+  } else if (formatName == "geojson") {
+    auto geojson = std::make_unique<GeoJsonFormat>();
+    geojson->setCoordinatePrecision(options.coord_digits);
+    geojson->setElevationPrecision(options.ele_digits);
+    return geojson;
+  } else if (formatName == "columnar") {
+    return std::make_unique<ColumnarFormat>();
+  } else if (formatName == "summary" || formatName == "summary-csv") {
+    auto summary = std::make_unique<SummaryFormat>(formatName == "summary-csv");
+    summary->setCoordinatePrecision(options.coord_digits);
+    summary->setThreads(options.threads);
+    return summary;
   }
+  return nullptr;
+}
 
-  Geodata geodata;
-  geodata.setDebugLevel(debug_level);
+// The cache key covers the input bytes and everything else that
+// changes the output bytes
+static quint64 cache_key(quint64 input_hash, const ProcessOptions& options, const OutputSpec& spec)
+{
+  QByteArray key;
+  key += QCoreApplication::applicationName().toUtf8() + ' ' + QCoreApplication::applicationVersion().toUtf8();
+  key += '|' + options.formatName.toUtf8();
+  key += '|' + spec.formatName.toUtf8();
+  key += '|' + QByteArray::number(CompressDevice::methodForFileName(spec.fileName));
+  key += '|' + options.creator.toUtf8();
+  key += '|' + QByteArray::number(options.testmode);
+  key += '|' + QByteArray::number(options.stitch, 'g', 17);
+  if (options.bbox) {
+    key += '|' + QByteArray::number(options.box.minlat, 'g', 17) + ',' + QByteArray::number(options.box.minlon, 'g', 17) +
+           ',' + QByteArray::number(options.box.maxlat, 'g', 17) + ',' + QByteArray::number(options.box.maxlon, 'g', 17);
+    key += '|' + QByteArray::number(options.clip);
+  }
+  key += '|' + QByteArray::number(options.simplify, 'g', 17);
+  key += '|' + QByteArray::number(options.compact);
+  key += '|' + QByteArray::number(options.name_copies);
+  key += '|' + QByteArray::number(options.coord_digits);
+  key += '|' + QByteArray::number(options.ele_digits);
+  return ConversionCache::hash(key.constData(), key.size(), input_hash);
+}
 
-  // Open the input file
-  std::unique_ptr<QFile> infile;
-  if (infileName == "-") {
-    infile = std::make_unique<QFile>();
-    if (!infile->open(stdin, QIODevice::ReadOnly)) {
-      qCritical() << "error opening file" << infileName;
-      exit(1);
+// Open the file of the output. Also called on the shard writer
+// threads, so errors are returned instead of terminating the process.
+static bool open_file(OutputFile* output, const QString& outfileName)
+{
+  // compressed and binary output must not be opened in text mode
+  if (outfileName != "-") {
+    output->compression = CompressDevice::methodForFileName(outfileName);
+  }
+  if (output->compression != CompressDevice::None && !CompressDevice::isSupported(output->compression)) {
+    qCritical() << "error: compression not supported for" << outfileName;
+    return false;
+  }
+  QIODevice::OpenMode outmode = QIODevice::WriteOnly;
+  if (output->compression == CompressDevice::None && output->writer->getName() != "columnar") {
+    outmode |= QIODevice::Text;
+  }
+
+  if (outfileName == "-") {
+    output->file = std::make_unique<QFile>();
+    if (!output->file->open(stdout, outmode)) {
+      qCritical() << "error: could not open stdout";
+      return false;
     }
   } else {
-    infile = std::make_unique<QFile>(infileName);
-    if (!infile->open(QIODevice::ReadOnly)) {
-      qCritical() << "error opening file" << infileName;
+    output->file = std::make_unique<QFile>(outfileName);
+    if (!output->file->open(outmode)) {
+      qCritical() << "error: could not open" << outfileName;
+      return false;
+    }
+  }
+  return true;
+}
+
+static void open_output(OutputFile* output, const QString& outfileName)
+{
+  if (!open_file(output, outfileName)) {
+    exit(1);
+  }
+}
+
+// Run write on the file of the output, compressing on the fly if
+// the output file name ends with .gz or .zst. Called on separate
+// threads, so errors are returned instead of terminating the process.
+static bool write_device(OutputFile* output, const std::function<void(QIODevice*)>& write)
+{
+  if (output->compression == CompressDevice::None) {
+    write(output->file.get());
+    return true;
+  }
+  CompressDevice compressor(output->file.get(), output->compression);
+  if (!compressor.open(QIODevice::WriteOnly)) {
+    qCritical() << "error: could not initialize compression for" << output->file->fileName();
+    return false;
+  }
+  write(&compressor);
+  compressor.close();
+  if (compressor.hasError()) {
+    qCritical() << "error: compressed write failed for" << output->file->fileName();
+    return false;
+  }
+  return true;
+}
+
+// Write geodata with the writer of the output
+static bool write_output(OutputFile* output, const Geodata* geodata)
+{
+  PhaseScope write_phase("write", output->writer->getName());
+  return write_device(output, [output, geodata](QIODevice* io) {
+    output->writer->write(io, geodata);
+  });
+}
+
+// <name>-0001.gpx for out.gpx, the compression suffix is kept at the
+// end
+static QString shard_file_name(const QString& fileName, size_t index)
+{
+  QString name = fileName;
+  QString compression;
+  if (name.endsWith(".gz") || name.endsWith(".zst")) {
+    compression = name.mid(name.lastIndexOf('.'));
+    name.chop(compression.size());
+  }
+  QString suffix;
+  const int dot = name.lastIndexOf('.');
+  if (dot > 0 && dot > name.lastIndexOf('/')) {
+    suffix = name.mid(dot);
+    name.truncate(dot);
+  }
+  return name + QString("-%1").arg(index, 4, 10, QChar('0')) + suffix + compression;
+}
+
+// Write a GPX output as shards with a limited size. The shards are
+// written concurrently, each with a writer of its own. A shard file
+// is only open while its shard is written, so the number of open
+// files is limited by the number of threads, not of shards.
+static bool write_shards(OutputFile* output, const Geodata* geodata, const ProcessOptions& options)
+{
+  PhaseScope write_phase("write", "gpx shards");
+  const auto* gpx = static_cast<const GpxFormat*>(output->writer.get());
+  const std::vector<GpxShard> shards = gpx->planShards(geodata, options.split);
+  if (options.debug_level > 0) {
+    qDebug() << "split:" << shards.size() << "shards for" << output->fileName;
+  }
+
+  std::vector<char> results(shards.size(), 0);
+  parallel_for(shards.size(), options.threads, [output, &options, &shards, &results](size_t i, int) {
+    OutputFile file;
+    file.fileName = shard_file_name(output->fileName, i + 1);
+    file.writer = create_writer("gpx", options);
+    if (!open_file(&file, file.fileName)) {
+      return;
+    }
+    const auto* writer = static_cast<const GpxFormat*>(file.writer.get());
+    const GpxShard& shard = shards[i];
+    results[i] = write_device(&file, [writer, &shard](QIODevice* io) {
+      writer->writeShard(io, shard);
+    });
+    file.file->close();
+  });
+  return std::all_of(results.begin(), results.end(), [](char result) {
+    return result != 0;
+  });
+}
+
+// Instantiate the output formats
+static std::vector<OutputFile> create_outputs(const ProcessOptions& options)
+{
+  std::vector<OutputFile> outputs(options.outputs.size());
+  for (size_t i = 0; i < options.outputs.size(); ++i) {
+    outputs[i].fileName = options.outputs[i].fileName;
+    outputs[i].writer = create_writer(options.outputs[i].formatName, options);
+    if (!outputs[i].writer) {
+      qCritical() << "no such output format:" << options.outputs[i].formatName;
       exit(1);
     }
   }
+  return outputs;
+}
 
-  // Instantiate input formats
+// The input format given by name, or the first one accepting the
+// input if the name is empty
+// Format of the input, nullptr and the reason in error if there is
+// none. Also called on the merge threads, so it does not exit.
+static std::unique_ptr<Format> find_format(QIODevice* input, const QString& formatName, int debug_level, QString* error)
+{
   std::list<std::unique_ptr<Format>> formats;
   formats.push_back(std::make_unique<GgvBinFormat>());
   formats.push_back(std::make_unique<GgvOvlFormat>());
   formats.push_back(std::make_unique<GgvXmlFormat>());
 
-  // Determine which input format to use (either auto-probe or by
-  // command line switch)
-  Format* format = NULL;
   if (formatName == "") {
-    for (auto&& f : std::as_const(formats)) {
-      if (f->probe(infile.get())) {
+    PhaseScope probe_phase("probe");
+    for (auto&& f : formats) {
+      if (f->probe(input)) {
         if (debug_level > 0) {
           qDebug().nospace() << "auto-probing " << f->getName() << ": true";
         }
-        format = f.get();
-        break;
+        return std::move(f);
       } else {
         if (debug_level > 0) {
           qDebug().nospace() << "auto-probing " << f->getName() << ": false";
         }
       }
     }
-    if (!format) {
-      qCritical() << "auto-probing failed";
+    *error = "auto-probing failed";
+    return nullptr;
+  }
+  for (auto&& f : formats) {
+    if (formatName == f->getName()) {
+      return std::move(f);
+    }
+  }
+  *error = QString("no such input format: \"%1\"").arg(formatName);
+  return nullptr;
+}
+
+static std::unique_ptr<Format> select_format(QIODevice* input, const QString& formatName, int debug_level)
+{
+  QString error;
+  std::unique_ptr<Format> format = find_format(input, formatName, debug_level, &error);
+  if (!format) {
+    qCritical().noquote() << error;
+    exit(1);
+  }
+  return format;
+}
+
+// Post processing and writing of the outputs, shared by single
+// conversions and merges
+static void finish_conversion(Geodata* geodata, std::vector<OutputFile> outputs, const ProcessOptions& options, bool use_cache)
+{
+  if (options.stitch > 0.0) {
+    PhaseScope stitch_phase("stitch");
+    const size_t joined = stitch_geodata(geodata, options.stitch);
+    if (options.debug_level > 0) {
+      qDebug() << "stitch:" << joined << "tracks joined";
+    }
+  }
+
+  if (options.bbox) {
+    PhaseScope bbox_phase("bbox");
+    spatial_select_geodata(geodata, options.box, options.clip);
+  }
+
+  if (options.simplify > 0.0) {
+    PhaseScope simplify_phase("simplify");
+    simplify_geodata(geodata, options.simplify);
+  }
+
+  // Tolerate no output file to be able to run input code only with
+  // debug enabled
+  if (outputs.empty()) {
+    return;
+  }
+
+  // GPX outputs split into shards are written here, the remaining
+  // outputs as usual
+  if (options.split.limit > 0) {
+    std::vector<OutputFile> unsplit;
+    for (auto&& output : outputs) {
+      if (output.writer->getName() != "gpx") {
+        unsplit.push_back(std::move(output));
+      } else if (!write_shards(&output, geodata, options)) {
+        exit(1);
+      }
+    }
+    outputs = std::move(unsplit);
+    if (outputs.empty()) {
+      return;
+    }
+  }
+
+  for (auto&& output : outputs) {
+    open_output(&output, output.fileName);
+  }
+
+  // Write output. Geodata is only read from here on, so several
+  // outputs are written concurrently on their own threads.
+  bool ok = true;
+  for (int i = 0; i < options.repeat; ++i) {
+    // every iteration produces the same output, so overwriting
+    // from the start leaves a valid file
+    if (i > 0) {
+      for (auto&& output : outputs) {
+        output.file->seek(0);
+      }
+    }
+    if (outputs.size() == 1) {
+      ok = write_output(&outputs.front(), geodata) && ok;
+    } else {
+      std::vector<char> results(outputs.size(), 0);
+      std::vector<std::thread> threads;
+      threads.reserve(outputs.size());
+      for (size_t j = 0; j < outputs.size(); ++j) {
+        threads.emplace_back([&outputs, &results, geodata, j]() {
+          results[j] = write_output(&outputs[j], geodata);
+        });
+      }
+      for (auto&& thread : threads) {
+        thread.join();
+      }
+      for (char result : results) {
+        ok = result && ok;
+      }
+    }
+  }
+  for (auto&& output : outputs) {
+    output.file->close();
+  }
+  if (!ok) {
+    exit(1);
+  }
+
+  if (use_cache) {
+    for (auto&& output : std::as_const(outputs)) {
+      if (output.fileName != "-" && !options.cache->store(output.cache_key, output.fileName)) {
+        qWarning() << "warning: could not store" << output.fileName << "in cache";
+      }
+    }
+  }
+}
+
+// Convert one input file. In batch mode the file contents are
+// already loaded and passed in preloaded.
+static void process_files(const QString& infileName, const ProcessOptions& options, const QByteArray* preloaded = nullptr)
+{
+  const QString& formatName = options.formatName;
+  const int debug_level = options.debug_level;
+
+  if (debug_level > 2) {
+    qDebug() << "process_files: format =" << formatName << " infile =" << infileName << " creator =" << options.creator;
+    for (auto&& spec : options.outputs) {
+      qDebug() << "process_files: output =" << spec.formatName << " outfile =" << spec.fileName;
+    }
+  }
+
+  TraceSpan file_span("file", "convert", infileName);
+
+  Geodata geodata;
+  geodata.setDebugLevel(debug_level);
+
+  std::vector<OutputFile> outputs = create_outputs(options);
+
+  // Open the input file, or read from the file already loaded in
+  // batch mode
+  std::unique_ptr<QFile> infile;
+  QBuffer inbuffer;
+  QIODevice* input = nullptr;
+  if (preloaded) {
+    inbuffer.setData(*preloaded);
+    inbuffer.open(QIODevice::ReadOnly);
+    input = &inbuffer;
+  } else if (infileName == "-") {
+    infile = std::make_unique<QFile>();
+    if (!infile->open(stdin, QIODevice::ReadOnly)) {
+      qCritical() << "error opening file" << infileName;
       exit(1);
     }
   } else {
-    for (auto&& f : std::as_const(formats)) {
-      if (formatName == f->getName()) {
-        format = f.get();
-        break;
+    infile = std::make_unique<QFile>(infileName);
+    if (!infile->open(QIODevice::ReadOnly)) {
+      qCritical() << "error opening file" << infileName;
+      exit(1);
+    }
+  }
+  if (infile) {
+    input = infile.get();
+  }
+
+  // Copy cached results without probing or parsing the input. Only
+  // the outputs that are not cached remain in the list.
+  const bool use_cache = options.cache && infileName != "-" && !outputs.empty();
+  if (use_cache) {
+    quint64 input_hash = preloaded ? ConversionCache::hash(preloaded->constData(), preloaded->size())
+                         : ConversionCache::hashFile(infile.get());
+    std::vector<OutputFile> misses;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      if (outputs[i].fileName == "-") {
+        misses.push_back(std::move(outputs[i]));
+        continue;
+      }
+      outputs[i].cache_key = cache_key(input_hash, options, options.outputs[i]);
+      if (options.cache->fetch(outputs[i].cache_key, outputs[i].fileName)) {
+        if (debug_level > 0) {
+          qDebug() << "cache hit:" << outputs[i].fileName;
+        }
+      } else {
+        misses.push_back(std::move(outputs[i]));
       }
     }
-    if (!format) {
-      qCritical() << "no such input format:" << formatName;
+    if (misses.empty()) {
+      return;
+    }
+    outputs = std::move(misses);
+  }
+
+  // Stages of the pipeline: a read-ahead thread reads the file, the
+  // format decodes it on this thread and completed items are
+  // formatted on a third thread. Only used for a single conversion
+  // of a regular file without post processing of the data.
+  const bool pipeline = options.pipeline && options.repeat == 1 && infile && infileName != "-";
+  std::unique_ptr<ReadAheadDevice> readahead;
+  if (pipeline) {
+    readahead = std::make_unique<ReadAheadDevice>(infileName);
+    if (!readahead->open(QIODevice::ReadOnly)) {
+      qCritical() << "error opening file" << infileName;
       exit(1);
     }
+    input = readahead.get();
   }
+  GpxFormat* pipeline_gpx = nullptr;
+  if (pipeline && options.stitch == 0.0 && !options.bbox && options.simplify == 0.0 && options.split.limit == 0 && outputs.size() == 1) {
+    pipeline_gpx = dynamic_cast<GpxFormat*>(outputs.front().writer.get());
+  }
+
+  // Determine which input format to use (either auto-probe or by
+  // command line switch)
+  std::unique_ptr<Format> format = select_format(input, formatName, debug_level);
 
   // Read the intput file
   format->setDebugLevel(debug_level);
-  format->read(infile.get(), &geodata);
+  for (int i = 0; i < options.repeat; ++i) {
+    if (i > 0) {
+      geodata = Geodata();
+      geodata.setDebugLevel(debug_level);
+    }
+    PhaseScope read_phase("read", format->getName());
+    if (pipeline_gpx) {
+      pipeline_gpx->startPipeline();
+      geodata.setObserver(pipeline_gpx);
+    }
+    if (preloaded) {
+      format->readBuffer(*preloaded, &geodata);
+    } else {
+      format->read(input, &geodata);
+    }
+    geodata.setObserver(nullptr);
+  }
+  // the readers take a failed read for the end of the data
+  if (readahead && readahead->hasError()) {
+    qCritical().noquote() << QString("error reading file \"%1\": %2").arg(infileName, readahead->errorString());
+    // joins the pipeline thread of a GPX output
+    outputs.clear();
+    exit(1);
+  }
+  readahead.reset();
 
-  // Tolerate empty output file to be able to run input code only with
-  // debug enabled
-  if (outfileName.isEmpty()) {
-    return;
+  finish_conversion(&geodata, std::move(outputs), options, use_cache);
+}
+
+// Read one of the files to merge. Called on the merge threads, so
+// errors are returned instead of terminating the process.
+static bool read_file(const QString& infileName, const ProcessOptions& options, Geodata* geodata, QString* error)
+{
+  TraceSpan file_span("file", "read", infileName);
+  QFile infile(infileName);
+  if (!infile.open(QIODevice::ReadOnly)) {
+    *error = QString("error opening file \"%1\"").arg(infileName);
+    return false;
   }
+  std::unique_ptr<Format> format = find_format(&infile, options.formatName, options.debug_level, error);
+  if (!format) {
+    *error = infileName + ": " + *error;
+    return false;
+  }
+  format->setDebugLevel(options.debug_level);
+  geodata->setDebugLevel(options.debug_level);
+  PhaseScope read_phase("read", format->getName());
+  format->read(&infile, geodata);
+  return true;
+}
 
-  // Open the output file
-  std::unique_ptr<QFile> outfile;
-  if (outfileName == "-") {
-    outfile = std::make_unique<QFile>();
-    if (!outfile->open(stdout, QIODevice::WriteOnly | QIODevice::Text)) {
-      qCritical() << "error: could not open stdout";
-      exit(1);
+// Read all input files in parallel and merge them in the order given
+// into one Geodata without duplicates
+static void merge_files(const QStringList& inputs, const ProcessOptions& options)
+{
+  std::vector<Geodata> sources(inputs.size());
+  std::vector<QString> errors(inputs.size());
+  std::vector<char> results(inputs.size(), 0);
+  parallel_for(sources.size(), options.threads, [&inputs, &options, &sources, &errors, &results](size_t i, int) {
+    results[i] = read_file(inputs.at(i), options, &sources[i], &errors[i]);
+  });
+  // reported after all threads are done, exit() must not run while
+  // others are still reading
+  if (std::find(results.begin(), results.end(), 0) != results.end()) {
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (!results[i]) {
+        qCritical().noquote() << errors[i];
+      }
     }
-  } else {
-    outfile = std::make_unique<QFile>(outfileName);
-    if (!outfile->open(QIODevice::WriteOnly | QIODevice::Text)) {
-      qCritical() << "error: could not open" << outfileName;
-      exit(1);
+    exit(1);
+  }
+
+  Geodata geodata;
+  geodata.setDebugLevel(options.debug_level);
+  {
+    PhaseScope merge_phase("merge");
+    GeodataMerger merger(&geodata, options.merge_tolerance);
+    for (auto&& source : sources) {
+      merger.add(&source);
+    }
+    if (options.debug_level > 0) {
+      qDebug() << "merge:" << inputs.size() << "files," << merger.duplicates() << "duplicates removed";
     }
   }
+  sources.clear();
 
-  // Write GPX
-  GpxFormat gpx;
-  gpx.setCreator(creator);
-  gpx.setTestmode(testmode);
-  gpx.write(outfile.get(), &geodata);
-  outfile.get()->close();
+  finish_conversion(&geodata, create_outputs(options), options, false);
+}
+
+static QString output_suffix(const QString& formatName)
+{
+  if (formatName == "columnar") {
+    return ".col";
+  } else if (formatName == "summary") {
+    return ".json";
+  } else if (formatName == "summary-csv") {
+    return ".csv";
+  }
+  return "." + formatName;
+}
+
+// Command line of the worker processes in watch mode
+static QStringList worker_arguments(const ProcessOptions& options, const QString& outputFormatName, const QString& cacheDir)
+{
+  QStringList args;
+  if (options.debug_level > 0) {
+    args << "-D" << QString::number(options.debug_level);
+  }
+  if (!options.formatName.isEmpty()) {
+    args << "-i" << options.formatName;
+  }
+  args << "-o" << outputFormatName;
+  if (options.stitch > 0.0) {
+    args << "--stitch" << QString::number(options.stitch, 'g', 17);
+  }
+  if (options.bbox) {
+    args << "--bbox" << QStringList({QString::number(options.box.minlat, 'g', 17), QString::number(options.box.minlon, 'g', 17),
+                                     QString::number(options.box.maxlat, 'g', 17), QString::number(options.box.maxlon, 'g', 17)
+                                    }).join(",");
+    if (options.clip) {
+      args << "--clip";
+    }
+  }
+  if (options.simplify > 0.0) {
+    args << "--simplify" << QString::number(options.simplify, 'g', 17);
+  }
+  if (options.split.limit > 0) {
+    static const char* const kUnits[] = {"points", "bytes", "objects"};
+    args << "--split-by" << QString("%1=%2").arg(kUnits[options.split.unit]).arg(options.split.limit);
+  }
+  if (options.compact) {
+    args << "--compact";
+  }
+  if (!options.name_copies) {
+    args << "--no-name-copies";
+  }
+  args << "--precision" << QString::number(options.coord_digits);
+  args << "--ele-precision" << QString::number(options.ele_digits);
+  if (!cacheDir.isEmpty()) {
+    args << "--cache" << cacheDir;
+  }
+  return args;
+}
+
+// minlat,minlon,maxlat,maxlon in degrees
+static bool parse_bbox(const QString& text, GeoBox* box)
+{
+  const QStringList parts = text.split(',');
+  if (parts.size() != 4) {
+    return false;
+  }
+  double values[4];
+  for (int i = 0; i < 4; ++i) {
+    bool ok = false;
+    values[i] = parts.at(i).trimmed().toDouble(&ok);
+    if (!ok || !std::isfinite(values[i])) {
+      return false;
+    }
+  }
+  *box = {values[0], values[1], values[2], values[3]};
+  return box->minlat <= box->maxlat && box->minlon <= box->maxlon;
+}
+
+// meters, 0 or at least GeoGrid::kMinTolerance
+static bool parse_tolerance(const QString& text, double* tolerance)
+{
+  bool ok = false;
+  *tolerance = text.toDouble(&ok);
+  return ok && std::isfinite(*tolerance) && (*tolerance == 0.0 || *tolerance >= GeoGrid::kMinTolerance);
+}
+
+// points=N, bytes=N or objects=N
+static bool parse_split(const QString& text, GpxSplit* split)
+{
+  const int equals = text.indexOf('=');
+  if (equals < 0) {
+    return false;
+  }
+  const QString unit = text.left(equals);
+  if (unit == "points") {
+    split->unit = GpxSplit::kPoints;
+  } else if (unit == "bytes") {
+    split->unit = GpxSplit::kBytes;
+  } else if (unit == "objects") {
+    split->unit = GpxSplit::kObjects;
+  } else {
+    return false;
+  }
+  bool ok = false;
+  split->limit = text.mid(equals + 1).toULongLong(&ok);
+  // a track part needs two points
+  const quint64 min = split->unit == GpxSplit::kPoints ? 2 : 1;
+  return ok && split->limit >= min;
+}
+
+static int parse_digits(const QCommandLineParser& parser, const QCommandLineOption& option)
+{
+  bool ok = false;
+  int digits = parser.value(option).toInt(&ok);
+  if (!ok || digits < 0 || digits > GpxFormat::kMaxDigits) {
+    qCritical() << qPrintable(QCoreApplication::applicationName()) << ": invalid precision" << parser.value(option);
+    exit(1);
+  }
+  return digits;
 }
 
 int main(int argc, char* argv[])
@@ -155,12 +772,84 @@ int main(int argc, char* argv[])
   QCommandLineOption inputFileOption("f", "input <file>", "file");
   parser.addOption(inputFileOption);
 
-  QCommandLineOption outputTypeOption("o", "output <type> (ignored)", "type");
+  QCommandLineOption outputTypeOption("o", "output <type> (gpx, geojson, columnar, summary, summary-csv) or <type>:<file>, repeatable", "type");
   parser.addOption(outputTypeOption);
 
-  QCommandLineOption outputFileOption("F", "output <file>", "file");
+  QCommandLineOption outputFileOption("F", "output <file> (.gz, .zst compress)", "file");
   parser.addOption(outputFileOption);
 
+  QCommandLineOption summaryOption("summary", "write route and track statistics to <file> (.csv for CSV, else JSON)", "file");
+  parser.addOption(summaryOption);
+
+  QCommandLineOption traceOption("trace", "write Chrome trace events to <file>", "file");
+  parser.addOption(traceOption);
+
+  QCommandLineOption statsOption("stats", "print time and allocations per phase");
+  parser.addOption(statsOption);
+
+  QCommandLineOption perfOption("perf", "add hardware performance counters to --stats (Linux)");
+  parser.addOption(perfOption);
+
+  QCommandLineOption statsFileOption("stats-file", "write machine readable stats to <file>", "file");
+  parser.addOption(statsFileOption);
+
+  QCommandLineOption repeatOption("repeat", "repeat read and write <count> times (benchmarking)", "count");
+  parser.addOption(repeatOption);
+
+  QCommandLineOption stitchOption("stitch", "join tracks with ends closer than <meters>", "meters");
+  parser.addOption(stitchOption);
+
+  QCommandLineOption bboxOption("bbox", "keep only objects inside <minlat,minlon,maxlat,maxlon>", "box");
+  parser.addOption(bboxOption);
+
+  QCommandLineOption clipOption("clip", "cut tracks at the edges of --bbox");
+  parser.addOption(clipOption);
+
+  QCommandLineOption simplifyOption("simplify", "simplify tracks and routes to <meters> tolerance", "meters");
+  parser.addOption(simplifyOption);
+
+  QCommandLineOption splitOption("split-by", "write GPX shards of at most points=N, bytes=N or objects=N", "limit");
+  parser.addOption(splitOption);
+
+  QCommandLineOption compactOption("compact", "write GPX without indentation");
+  parser.addOption(compactOption);
+
+  QCommandLineOption precisionOption("precision", "number of coordinate <digits> (default 9)", "digits");
+  parser.addOption(precisionOption);
+
+  QCommandLineOption elePrecisionOption("ele-precision", "number of elevation <digits> (default 9)", "digits");
+  parser.addOption(elePrecisionOption);
+
+  QCommandLineOption noNameCopiesOption("no-name-copies", "do not copy waypoint names to cmt and desc");
+  parser.addOption(noNameCopiesOption);
+
+  QCommandLineOption threadsOption("threads", "number of worker threads (default: automatic)", "count");
+  parser.addOption(threadsOption);
+
+  QCommandLineOption noPipelineOption("no-pipeline", "read, decode and write one after the other");
+  parser.addOption(noPipelineOption);
+
+  QCommandLineOption outDirOption("out", "batch mode: convert all input files into <dir>", "dir");
+  parser.addOption(outDirOption);
+
+  QCommandLineOption inflightOption("inflight", "number of files read ahead in batch mode (default 32)", "count");
+  parser.addOption(inflightOption);
+
+  QCommandLineOption cacheOption("cache", "reuse conversion results stored in <dir>", "dir");
+  parser.addOption(cacheOption);
+
+  QCommandLineOption watchOption("watch", "convert .ovl files written to <dir> into --out", "dir");
+  parser.addOption(watchOption);
+
+  QCommandLineOption mergeOption("merge", "merge all input files into one output without duplicates");
+  parser.addOption(mergeOption);
+
+  QCommandLineOption mergeToleranceOption("merge-tolerance", "also drop waypoints with the same name within <meters>", "meters");
+  parser.addOption(mergeToleranceOption);
+
+  QCommandLineOption jobsOption("jobs", "number of parallel conversions in watch mode", "count");
+  parser.addOption(jobsOption);
+
   parser.addPositionalArgument("infile", "input file (alternative to -f)");
   parser.addPositionalArgument("outfile","output file (alternative to -F)");
 
@@ -177,9 +866,42 @@ int main(int argc, char* argv[])
     }
   }
 
+  // In batch mode all positional arguments are input files and the
+  // output file names are derived from them
+  const bool batch = parser.isSet(outDirOption);
+  const bool merge = parser.isSet(mergeOption);
+  QStringList batch_inputs;
   QString infile("");
   QString outfile("");
-  if (parser.positionalArguments().size() > 2) {
+  if (merge) {
+    // all positional arguments are inputs, the output is given with
+    // -F or -o <type>:<file>
+    batch_inputs = parser.positionalArguments();
+    if (parser.isSet(inputFileOption)) {
+      batch_inputs.append(parser.value(inputFileOption));
+    }
+    if (batch || parser.isSet(watchOption)) {
+      qCritical() << qPrintable(app.applicationName()) << ": --merge cannot be combined with --out or --watch";
+      exit(1);
+    }
+    if (batch_inputs.isEmpty() || batch_inputs.contains("-")) {
+      qCritical() << qPrintable(app.applicationName()) << ": --merge needs regular input files";
+      exit(1);
+    }
+  } else if (batch) {
+    batch_inputs = parser.positionalArguments();
+    if (parser.isSet(inputFileOption)) {
+      batch_inputs.append(parser.value(inputFileOption));
+    }
+    if (parser.isSet(outputFileOption)) {
+      qCritical() << qPrintable(app.applicationName()) << ": --out cannot be combined with -F";
+      exit(1);
+    }
+    if (batch_inputs.contains("-")) {
+      qCritical() << qPrintable(app.applicationName()) << ": --out needs regular input files";
+      exit(1);
+    }
+  } else if (parser.positionalArguments().size() > 2) {
     qCritical() << qPrintable(app.applicationName()) << ": too many positional arguments";
     exit(1);
   } else if (parser.positionalArguments().size() == 2) {
@@ -189,7 +911,7 @@ int main(int argc, char* argv[])
     infile = parser.positionalArguments().at(0);
   }
 
-  if (parser.isSet(inputFileOption)) {
+  if (parser.isSet(inputFileOption) && !batch && !merge) {
     infile = parser.value(inputFileOption);
   }
 
@@ -197,21 +919,282 @@ int main(int argc, char* argv[])
     outfile = parser.value(outputFileOption);
   }
 
-  QString creator = "ggvtogpx";
+  ProcessOptions options;
+  options.debug_level = debug_level;
+
+  options.creator = "ggvtogpx";
   if (qEnvironmentVariableIsSet("GGVTOGPX_CREATOR")) {
-    creator = qEnvironmentVariable("GGVTOGPX_CREATOR");
+    options.creator = qEnvironmentVariable("GGVTOGPX_CREATOR");
   }
 
-  bool testmode = false;
   if (qEnvironmentVariableIsSet("GGVTOGPX_TESTMODE")) {
-    testmode = true;
+    options.testmode = true;
   }
 
-  QString formatName;
   if (parser.isSet(inputTypeOption)) {
-    formatName = parser.value(inputTypeOption);
+    options.formatName = parser.value(inputTypeOption);
+  }
+
+  // -o <type> selects the format of the output file, every
+  // -o <type>:<file> adds another output
+  QString outputFormatName("gpx");
+  int plain_types = 0;
+  for (auto&& value : parser.values(outputTypeOption)) {
+    int colon = value.indexOf(':');
+    if (colon > 0) {
+      options.outputs.push_back({value.left(colon), value.mid(colon + 1)});
+    } else {
+      outputFormatName = value;
+      plain_types++;
+    }
+  }
+  if (plain_types > 1) {
+    qCritical() << qPrintable(app.applicationName()) << ": more than one output type without file";
+    exit(1);
+  }
+  if (!outfile.isEmpty()) {
+    options.outputs.insert(options.outputs.begin(), {outputFormatName, outfile});
+  }
+  if (parser.isSet(summaryOption)) {
+    const QString summary_file = parser.value(summaryOption);
+    const bool csv = summary_file.endsWith(".csv") || summary_file.endsWith(".csv.gz") || summary_file.endsWith(".csv.zst");
+    options.outputs.push_back({csv ? "summary-csv" : "summary", summary_file});
+  }
+  int stdout_count = 0;
+  QStringList output_files;
+  for (auto&& spec : options.outputs) {
+    if (spec.fileName.isEmpty()) {
+      qCritical() << qPrintable(app.applicationName()) << ": missing output file for type" << spec.formatName;
+      exit(1);
+    }
+    if (spec.fileName != "-" && output_files.contains(spec.fileName)) {
+      qCritical() << qPrintable(app.applicationName()) << ": output file given twice:" << spec.fileName;
+      exit(1);
+    }
+    output_files.append(spec.fileName);
+    if (spec.fileName == "-") {
+      stdout_count++;
+    }
+  }
+  if (stdout_count > 1) {
+    qCritical() << qPrintable(app.applicationName()) << ": only one output can be written to stdout";
+    exit(1);
+  }
+  if (batch && !options.outputs.empty()) {
+    qCritical() << qPrintable(app.applicationName()) << ": --out cannot be combined with -o <type>:<file>";
+    exit(1);
+  }
+
+  if (parser.isSet(stitchOption)) {
+    if (!parse_tolerance(parser.value(stitchOption), &options.stitch)) {
+      qCritical() << qPrintable(app.applicationName()) << ": invalid stitch tolerance, use 0 or at least"
+                  << GeoGrid::kMinTolerance << "meters";
+      exit(1);
+    }
+  }
+
+  if (parser.isSet(bboxOption)) {
+    if (!parse_bbox(parser.value(bboxOption), &options.box)) {
+      qCritical() << qPrintable(app.applicationName()) << ": invalid bounding box" << parser.value(bboxOption);
+      exit(1);
+    }
+    options.bbox = true;
+  }
+  options.clip = parser.isSet(clipOption);
+  if (options.clip && !options.bbox) {
+    qCritical() << qPrintable(app.applicationName()) << ": --clip needs --bbox";
+    exit(1);
+  }
+
+  if (parser.isSet(simplifyOption)) {
+    bool ok = false;
+    options.simplify = parser.value(simplifyOption).toDouble(&ok);
+    if (!ok || options.simplify < 0.0) {
+      qCritical() << qPrintable(app.applicationName()) << ": invalid simplify tolerance";
+      exit(1);
+    }
+  }
+
+  if (parser.isSet(mergeToleranceOption)) {
+    if (!parse_tolerance(parser.value(mergeToleranceOption), &options.merge_tolerance)) {
+      qCritical() << qPrintable(app.applicationName()) << ": invalid merge tolerance, use 0 or at least"
+                  << GeoGrid::kMinTolerance << "meters";
+      exit(1);
+    }
+    if (!merge) {
+      qCritical() << qPrintable(app.applicationName()) << ": --merge-tolerance needs --merge";
+      exit(1);
+    }
+  }
+  if (merge && parser.isSet(cacheOption)) {
+    qCritical() << qPrintable(app.applicationName()) << ": --merge cannot be combined with --cache";
+    exit(1);
+  }
+
+  if (parser.isSet(splitOption)) {
+    if (!parse_split(parser.value(splitOption), &options.split)) {
+      qCritical() << qPrintable(app.applicationName()) << ": invalid split limit" << parser.value(splitOption);
+      exit(1);
+    }
+    if (stdout_count > 0) {
+      qCritical() << qPrintable(app.applicationName()) << ": --split-by needs output files";
+      exit(1);
+    }
+    if (parser.isSet(cacheOption)) {
+      qCritical() << qPrintable(app.applicationName()) << ": --split-by cannot be combined with --cache";
+      exit(1);
+    }
+  }
+
+  options.compact = parser.isSet(compactOption);
+  options.name_copies = !parser.isSet(noNameCopiesOption);
+  if (parser.isSet(precisionOption)) {
+    options.coord_digits = parse_digits(parser, precisionOption);
   }
+  if (parser.isSet(elePrecisionOption)) {
+    options.ele_digits = parse_digits(parser, elePrecisionOption);
+  }
+
+  options.pipeline = !parser.isSet(noPipelineOption);
 
-  process_files(formatName, infile, outfile, creator, testmode, debug_level);
+  if (parser.isSet(threadsOption)) {
+    bool ok = false;
+    options.threads = parser.value(threadsOption).toInt(&ok);
+    if (!ok || options.threads < 1) {
+      qCritical() << qPrintable(app.applicationName()) << ": invalid number of threads";
+      exit(1);
+    }
+  }
+
+  if (parser.isSet(repeatOption)) {
+    bool ok = false;
+    options.repeat = parser.value(repeatOption).toInt(&ok);
+    if (!ok || options.repeat < 1) {
+      qCritical() << qPrintable(app.applicationName()) << ": invalid repeat count";
+      exit(1);
+    }
+    if (options.repeat > 1 && (infile == "-" || stdout_count > 0)) {
+      qCritical() << qPrintable(app.applicationName()) << ": --repeat needs regular input and output files";
+      exit(1);
+    }
+  }
+
+  std::unique_ptr<ConversionCache> cache;
+  if (parser.isSet(cacheOption)) {
+    cache = std::make_unique<ConversionCache>(parser.value(cacheOption));
+    if (!cache->isValid()) {
+      qCritical() << qPrintable(app.applicationName()) << ": could not create cache directory" << parser.value(cacheOption);
+      exit(1);
+    }
+    options.cache = cache.get();
+  }
+
+  QString tracefile;
+  if (parser.isSet(traceOption)) {
+    tracefile = parser.value(traceOption);
+    Trace::enable();
+  }
+
+  if (parser.isSet(statsOption) || parser.isSet(perfOption) || parser.isSet(statsFileOption)) {
+    Stats::enable();
+    // the read-ahead and formatting threads of the pipeline span the
+    // phases, their work could not be attributed to either of them
+    options.pipeline = false;
+  }
+  if (parser.isSet(perfOption)) {
+    Stats::enablePerfCounters();
+  }
+
+  if (parser.isSet(watchOption)) {
+    if (!batch || !batch_inputs.isEmpty()) {
+      qCritical() << qPrintable(app.applicationName()) << ": --watch needs --out and no input files";
+      exit(1);
+    }
+    int jobs = QThread::idealThreadCount();
+    if (parser.isSet(jobsOption)) {
+      bool ok = false;
+      jobs = parser.value(jobsOption).toInt(&ok);
+      if (!ok || jobs < 1) {
+        qCritical() << qPrintable(app.applicationName()) << ": invalid number of jobs";
+        exit(1);
+      }
+    }
+    QDir outdir(parser.value(outDirOption));
+    if (!outdir.mkpath(".")) {
+      qCritical() << qPrintable(app.applicationName()) << ": could not create output directory" << outdir.path();
+      exit(1);
+    }
+    DirectoryWatcher watcher(parser.value(watchOption), outdir.path(), output_suffix(outputFormatName),
+                             worker_arguments(options, outputFormatName, parser.value(cacheOption)), jobs);
+    watcher.setDebugLevel(debug_level);
+    if (!watcher.start()) {
+      qCritical() << qPrintable(app.applicationName()) << ": could not watch directory" << parser.value(watchOption);
+      exit(1);
+    }
+    return app.exec();
+  }
+
+  if (batch) {
+    QDir outdir(parser.value(outDirOption));
+    if (!outdir.mkpath(".")) {
+      qCritical() << qPrintable(app.applicationName()) << ": could not create output directory" << outdir.path();
+      exit(1);
+    }
+    int inflight = BatchIngest::kDefaultInflight;
+    if (parser.isSet(inflightOption)) {
+      bool ok = false;
+      inflight = parser.value(inflightOption).toInt(&ok);
+      if (!ok || inflight < 1) {
+        qCritical() << qPrintable(app.applicationName()) << ": invalid number of files in flight";
+        exit(1);
+      }
+    }
+    // Inputs with the same base name in different directories would
+    // overwrite each other's output
+    QHash<QString, QString> output_inputs;
+    for (const auto& input : std::as_const(batch_inputs)) {
+      const QString outfile = QFileInfo(input).completeBaseName() + output_suffix(outputFormatName);
+      auto it = output_inputs.find(outfile);
+      if (it != output_inputs.end()) {
+        qCritical() << qPrintable(app.applicationName()) << ": inputs" << it.value() << "and" << input
+                    << "are both written to" << outdir.filePath(outfile);
+        exit(1);
+      }
+      output_inputs.insert(outfile, input);
+    }
+    BatchIngest ingest(batch_inputs, inflight);
+    if (debug_level > 0) {
+      qDebug() << "batch: io_uring" << (ingest.usesUring() ? "enabled" : "not available");
+    }
+    QString input;
+    QByteArray data;
+    int error = 0;
+    while (ingest.next(&input, &data, &error)) {
+      if (error != 0) {
+        qCritical() << "error opening file" << input << ":" << qPrintable(qt_error_string(error));
+        exit(1);
+      }
+      ProcessOptions file_options = options;
+      file_options.outputs = {{outputFormatName, outdir.filePath(QFileInfo(input).completeBaseName() + output_suffix(outputFormatName))}};
+      process_files(input, file_options, &data);
+    }
+  } else if (merge) {
+    merge_files(batch_inputs, options);
+  } else {
+    process_files(infile, options);
+  }
+
+  if (parser.isSet(statsOption) || parser.isSet(perfOption)) {
+    Stats::report();
+  }
+  if (parser.isSet(statsFileOption) && !Stats::writeFile(parser.value(statsFileOption))) {
+    qCritical() << "error: could not write stats file" << parser.value(statsFileOption);
+    exit(1);
+  }
+
+  if (!tracefile.isEmpty() && !Trace::write(tracefile)) {
+    qCritical() << "error: could not write trace file" << tracefile;
+    exit(1);
+  }
   exit(0);
 }
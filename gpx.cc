@@ -24,103 +24,613 @@
 #include <QTimeZone>
 #include <QXmlStreamWriter>
 
+#include <algorithm>
 #include <cmath>
+#include <mutex>
+#include <thread>
 
 #include "gpx.h"
+#include "parallel.h"
+#include "trace.h"
 
-static const auto kNumDigits = 9;
+// write this many points per chunk at least when formatting in
+// parallel, and only use threads for documents with more points
+static const size_t kMinChunkPoints = 4096;
+static const size_t kParallelMinPoints = 65536;
 
 static void
-gpx_write_waypoint(QXmlStreamWriter& xml, Waypoint* waypoint)
+gpx_write_waypoint(QXmlStreamWriter& xml, const Waypoint* waypoint, int coord_digits, int ele_digits)
 {
-  xml.writeAttribute(QStringLiteral("lat"), QString::number(waypoint->latitude, 'f', kNumDigits));
-  xml.writeAttribute(QStringLiteral("lon"), QString::number(waypoint->longitude, 'f', kNumDigits));
+  xml.writeAttribute(QStringLiteral("lat"), QString::number(waypoint->latitude, 'f', coord_digits));
+  xml.writeAttribute(QStringLiteral("lon"), QString::number(waypoint->longitude, 'f', coord_digits));
   if (! std::isnan(waypoint->elevation)) {
-    xml.writeTextElement(QStringLiteral("ele"), QString::number(waypoint->elevation, 'f', kNumDigits));
+    xml.writeTextElement(QStringLiteral("ele"), QString::number(waypoint->elevation, 'f', ele_digits));
   }
 }
 
-void
-GpxFormat::write(QIODevice* io, const Geodata* geodata)
+// Same escaping as QXmlStreamWriter::writeCharacters(). Names with
+// characters the writer rejects or treats specially are left to it.
+static bool
+gpx_escape_name(const QString& name, QByteArray* out)
 {
-  QXmlStreamWriter xml;
-  xml.setAutoFormatting(true);
-  xml.setAutoFormattingIndent(2);
-  xml.setDevice(io);
-  xml.writeStartDocument();
-  xml.writeStartElement(QStringLiteral("gpx"));
-  xml.writeAttribute(QStringLiteral("version"), QStringLiteral("1.0"));
-  xml.writeAttribute(QStringLiteral("creator"), creator);
-  xml.writeAttribute(QStringLiteral("xmlns"), QStringLiteral("http://www.topografix.com/GPX/1/0"));
+  QString escaped;
+  escaped.reserve(name.size());
+  for (QChar c : name) {
+    const char16_t u = c.unicode();
+    if (u < 0x20 || (u >= 0xd800 && u <= 0xdfff) || u == 0xfffe || u == 0xffff) {
+      return false;
+    }
+    if (u == '<') {
+      escaped += QLatin1String("&lt;");
+    } else if (u == '>') {
+      escaped += QLatin1String("&gt;");
+    } else if (u == '&') {
+      escaped += QLatin1String("&amp;");
+    } else if (u == '"') {
+      escaped += QLatin1String("&quot;");
+    } else {
+      escaped += c;
+    }
+  }
+  *out = escaped.toUtf8();
+  return true;
+}
 
-  QString time;
-  if (testmode) {
-    time = QDateTime::fromSecsSinceEpoch(0, QTimeZone("UTC")).toString(Qt::ISODate);
-  } else {
-    time = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+const QByteArray*
+GpxNameCache::escaped(const QString& name)
+{
+  auto it = entries.find(name.constData());
+  if (it == entries.end()) {
+    Entry entry{name, QByteArray(), false};
+    entry.valid = gpx_escape_name(name, &entry.escaped);
+    it = entries.insert(name.constData(), entry);
   }
-  xml.writeTextElement(QStringLiteral("time"), time);
+  return it->valid ? &it->escaped : nullptr;
+}
+
+// Like xml.writeTextElement(), but with the cached escaped name. The
+// writer does not buffer, so the name can be written to the device
+// directly once the start tag is complete.
+static void
+gpx_write_name(QXmlStreamWriter& xml, GpxNameCache* names, const QString& element, const QString& name)
+{
+  const QByteArray* escaped = names->escaped(name);
+  if (!escaped) {
+    xml.writeTextElement(element, name);
+    return;
+  }
+  xml.writeStartElement(element);
+  // closes the start tag
+  xml.writeCharacters(QString());
+  xml.device()->write(*escaped);
+  xml.writeEndElement();
+}
 
-  auto bounds = geodata->getBounds();
-  Waypoint min = bounds.first;
-  Waypoint max = bounds.second;
+// Points of a route or track written for an item
+static std::pair<size_t, size_t>
+gpx_item_range(const GpxItem& item)
+{
+  const size_t size = item.list->getWaypoints().size();
+  return {std::min(item.first, size), std::min(item.end, size)};
+}
 
+// All items of the document in the order they are written
+static std::vector<GpxItem>
+gpx_collect_items(const Geodata* geodata)
+{
+  std::vector<GpxItem> items;
+  items.reserve(geodata->getWaypoints().size() + geodata->getRoutes().size() + geodata->getTracks().size());
+  for (auto&& waypoint : std::as_const(geodata->getWaypoints())) {
+    items.push_back({GpxItem::kWaypoint, &waypoint, nullptr, 1});
+  }
+  for (auto&& route : std::as_const(geodata->getRoutes())) {
+    items.push_back({GpxItem::kRoute, nullptr, &route, route.getWaypoints().size() + 1});
+  }
+  for (auto&& track : std::as_const(geodata->getTracks())) {
+    items.push_back({GpxItem::kTrack, nullptr, &track, track.getWaypoints().size() + 1});
+  }
+  return items;
+}
 
-  if (! geodata->getRoutes().empty() || ! geodata->getTracks().empty() || ! geodata->getWaypoints().empty()) {
-    xml.writeStartElement(QStringLiteral("bounds"));
-    xml.writeAttribute(QStringLiteral("minlat"), QString::number(min.latitude, 'f', kNumDigits));
-    xml.writeAttribute(QStringLiteral("minlon"), QString::number(min.longitude, 'f', kNumDigits));
-    xml.writeAttribute(QStringLiteral("maxlat"), QString::number(max.latitude, 'f', kNumDigits));
-    xml.writeAttribute(QStringLiteral("maxlon"), QString::number(max.longitude, 'f', kNumDigits));
-    xml.writeEndElement();
+// Bounds of the points written for the items, computed like
+// Geodata::getBounds()
+static std::pair<Waypoint, Waypoint>
+gpx_item_bounds(const std::vector<GpxItem>& items)
+{
+  Waypoint min(90.0, 180.0);
+  Waypoint max(0.0, -180.0);
+  auto extend = [&min, &max](const Waypoint& waypoint) {
+    if (waypoint.latitude > max.latitude) {
+      max.latitude = waypoint.latitude;
+    }
+    if (waypoint.latitude < min.latitude) {
+      min.latitude = waypoint.latitude;
+    }
+    if (waypoint.longitude > max.longitude) {
+      max.longitude = waypoint.longitude;
+    }
+    if (waypoint.longitude < min.longitude) {
+      min.longitude = waypoint.longitude;
+    }
+  };
+  for (auto&& item : items) {
+    if (item.kind == GpxItem::kWaypoint) {
+      extend(*item.waypoint);
+      continue;
+    }
+    const auto& points = item.list->getWaypoints();
+    auto [first, end] = gpx_item_range(item);
+    for (size_t i = first; i < end; ++i) {
+      extend(points[i]);
+    }
   }
+  return std::make_pair(min, max);
+}
 
-  for (auto&& waypoint : std::as_const(geodata->getWaypoints())) {
+void
+GpxFormat::writeItem(QXmlStreamWriter& xml, GpxNameCache* names, const GpxItem& item) const
+{
+  switch (item.kind) {
+  case GpxItem::kWaypoint: {
+    const Waypoint* waypoint = item.waypoint;
     xml.writeStartElement(QStringLiteral("wpt"));
-    gpx_write_waypoint(xml, waypoint.get());
+    gpx_write_waypoint(xml, waypoint, coord_digits, ele_digits);
     if (! waypoint->name.isEmpty()) {
-      xml.writeTextElement(QStringLiteral("name"), waypoint->name);
-      xml.writeTextElement(QStringLiteral("cmt"), waypoint->name);
-      xml.writeTextElement(QStringLiteral("desc"), waypoint->name);
+      gpx_write_name(xml, names, QStringLiteral("name"), waypoint->name);
+      if (name_copies) {
+        gpx_write_name(xml, names, QStringLiteral("cmt"), waypoint->name);
+        gpx_write_name(xml, names, QStringLiteral("desc"), waypoint->name);
+      }
     }
     xml.writeEndElement();
   }
+  break;
 
-  for (auto&& route : std::as_const(geodata->getRoutes())) {
+  case GpxItem::kRoute: {
+    const WaypointList* route = item.list;
     xml.writeStartElement(QStringLiteral("rte"));
     if (! route->name.isEmpty()) {
-      xml.writeTextElement(QStringLiteral("name"), route->name);
+      gpx_write_name(xml, names, QStringLiteral("name"), route->name);
     }
-    for (auto&& waypoint : std::as_const(route->getWaypoints())) {
+    const auto& points = route->getWaypoints();
+    auto [first, end] = gpx_item_range(item);
+    for (size_t i = first; i < end; ++i) {
+      const Waypoint& waypoint = points[i];
       xml.writeStartElement(QStringLiteral("rtept"));
-      gpx_write_waypoint(xml, waypoint.get());
-      if (! waypoint->name.isEmpty()) {
-        xml.writeTextElement(QStringLiteral("name"), waypoint->name);
+      gpx_write_waypoint(xml, &waypoint, coord_digits, ele_digits);
+      if (! waypoint.name.isEmpty()) {
+        gpx_write_name(xml, names, QStringLiteral("name"), waypoint.name);
       }
       xml.writeEndElement();
     }
     xml.writeEndElement();
   }
+  break;
 
-  for (auto&& track : std::as_const(geodata->getTracks())) {
+  case GpxItem::kTrack: {
+    const WaypointList* track = item.list;
     xml.writeStartElement(QStringLiteral("trk"));
     if (! track->name.isEmpty()) {
-      xml.writeTextElement(QStringLiteral("name"), track->name);
+      gpx_write_name(xml, names, QStringLiteral("name"), track->name);
     }
     xml.writeStartElement(QStringLiteral("trkseg"));
-    for (auto&& waypoint : std::as_const(track->getWaypoints())) {
+    const auto& points = track->getWaypoints();
+    auto [first, end] = gpx_item_range(item);
+    for (size_t i = first; i < end; ++i) {
       xml.writeStartElement(QStringLiteral("trkpt"));
-      gpx_write_waypoint(xml, waypoint.get());
+      gpx_write_waypoint(xml, &points[i], coord_digits, ele_digits);
       xml.writeEndElement();
     }
     xml.writeEndElement();
     xml.writeEndElement();
   }
+  break;
+  }
+}
+
+// Format a range of items into a buffer. The items are written into
+// a dummy root element, so they get the same indentation and line
+// breaks as in the document. Everything up to the "<gpx>" of the
+// dummy root is removed and the root is never closed.
+QByteArray
+GpxFormat::formatChunk(const GpxItem* begin, const GpxItem* end) const
+{
+  static const QByteArray kPrefix("<gpx>");
+  QByteArray buffer;
+  {
+    QXmlStreamWriter xml(&buffer);
+    xml.setAutoFormatting(!compact);
+    xml.setAutoFormattingIndent(2);
+    xml.writeStartElement(QStringLiteral("gpx"));
+    GpxNameCache names;
+    for (const GpxItem* item = begin; item != end; ++item) {
+      writeItem(xml, &names, *item);
+    }
+  }
+  buffer.remove(0, buffer.indexOf(kPrefix) + kPrefix.size());
+  return buffer;
+}
+
+// Format chunks of items on several threads and write them in the
+// original order as soon as the next chunk is complete
+void
+GpxFormat::writeParallel(QIODevice* io, const std::vector<GpxItem>& items, size_t points, int nthreads) const
+{
+  // a few chunks per thread to balance tracks of different size,
+  // small documents only get here with an explicit thread count
+  const size_t min_points = points < kParallelMinPoints ? 1 : kMinChunkPoints;
+  const size_t chunk_points = std::max(points / (nthreads * 4), min_points);
+  std::vector<std::pair<size_t, size_t>> chunks;
+  size_t begin = 0;
+  size_t weight = 0;
+  for (size_t i = 0; i < items.size(); ++i) {
+    weight += items[i].points;
+    if (weight >= chunk_points) {
+      chunks.emplace_back(begin, i + 1);
+      begin = i + 1;
+      weight = 0;
+    }
+  }
+  if (begin < items.size()) {
+    chunks.emplace_back(begin, items.size());
+  }
+
+  // a finished chunk is kept until the chunks before it are written,
+  // whichever thread completes the next chunk in order writes it
+  std::vector<QByteArray> results(chunks.size());
+  std::vector<char> done(chunks.size(), 0);
+  size_t written = 0;
+  std::mutex mutex;
+  parallel_for(chunks.size(), nthreads, [&](size_t i, int) {
+    QByteArray buffer = formatChunk(items.data() + chunks[i].first, items.data() + chunks[i].second);
+    std::lock_guard<std::mutex> lock(mutex);
+    results[i] = std::move(buffer);
+    done[i] = 1;
+    for (; written < chunks.size() && done[written]; ++written) {
+      io->write(results[written]);
+      results[written] = QByteArray();
+    }
+  });
+}
+
+/**********************************************************************/
+
+GpxFormat::~GpxFormat()
+{
+  if (pipeline_thread.joinable()) {
+    pipeline_done = true;
+    pipeline_thread.join();
+  }
+}
+
+void
+GpxFormat::startPipeline()
+{
+  pipeline_queue = std::make_unique<SpscQueue<GpxItem>>(4096);
+  pipeline_done = false;
+  for (int i = 0; i < 3; ++i) {
+    preformatted[i].clear();
+    preformatted_count[i] = 0;
+  }
+  pipeline_thread = std::thread(&GpxFormat::runPipeline, this);
+}
+
+void
+GpxFormat::pushItem(GpxItem item)
+{
+  int spins = 0;
+  while (!pipeline_queue->tryPush(item)) {
+    SpscQueue<GpxItem>::backoff(spins);
+  }
+}
+
+void
+GpxFormat::waypointAdded(const Waypoint* waypoint)
+{
+  pushItem({GpxItem::kWaypoint, waypoint, nullptr, 1});
+}
+
+void
+GpxFormat::routeAdded(const WaypointList* route)
+{
+  pushItem({GpxItem::kRoute, nullptr, route, route->getWaypoints().size() + 1});
+}
+
+void
+GpxFormat::trackAdded(const WaypointList* track)
+{
+  pushItem({GpxItem::kTrack, nullptr, track, track->getWaypoints().size() + 1});
+}
+
+// Pipeline thread: one writer per kind, each into a dummy root like
+// formatChunk(), so the items of a kind end up in document order
+void
+GpxFormat::runPipeline()
+{
+  TraceSpan span("writer", "gpx pipeline");
+  std::unique_ptr<QXmlStreamWriter> writers[3];
+  GpxNameCache names;
+  GpxItem item;
+  int spins = 0;
+  for (;;) {
+    if (!pipeline_queue->tryPop(item)) {
+      if (!pipeline_done.load(std::memory_order_acquire)) {
+        SpscQueue<GpxItem>::backoff(spins);
+        continue;
+      }
+      // the flag is set after the last push, one more attempt sees
+      // everything the reader has added
+      if (!pipeline_queue->tryPop(item)) {
+        break;
+      }
+    }
+    spins = 0;
+    auto& xml = writers[item.kind];
+    if (!xml) {
+      xml = std::make_unique<QXmlStreamWriter>(&preformatted[item.kind]);
+      xml->setAutoFormatting(!compact);
+      xml->setAutoFormattingIndent(2);
+      xml->writeStartElement(QStringLiteral("gpx"));
+    }
+    writeItem(*xml, &names, item);
+    preformatted_count[item.kind]++;
+  }
+  static const QByteArray kPrefix("<gpx>");
+  for (int i = 0; i < 3; ++i) {
+    writers[i].reset();
+    if (!preformatted[i].isEmpty()) {
+      preformatted[i].remove(0, preformatted[i].indexOf(kPrefix) + kPrefix.size());
+    }
+  }
+}
+
+// Wait for the pipeline thread. The result can only be used if the
+// items still match the Geodata.
+bool
+GpxFormat::finishPipeline(const Geodata* geodata)
+{
+  pipeline_done.store(true, std::memory_order_release);
+  pipeline_thread.join();
+  pipeline_queue.reset();
+  return preformatted_count[GpxItem::kWaypoint] == geodata->getWaypoints().size() &&
+         preformatted_count[GpxItem::kRoute] == geodata->getRoutes().size() &&
+         preformatted_count[GpxItem::kTrack] == geodata->getTracks().size();
+}
+
+void
+GpxFormat::write(QIODevice* io, const Geodata* geodata)
+{
+  bool use_pipeline = false;
+  if (pipeline_thread.joinable()) {
+    use_pipeline = finishPipeline(geodata);
+  }
+
+  QXmlStreamWriter xml;
+  xml.setAutoFormatting(!compact);
+  xml.setAutoFormattingIndent(2);
+  xml.setDevice(io);
+  xml.writeStartDocument();
+  const bool has_bounds = ! geodata->getRoutes().empty() || ! geodata->getTracks().empty() || ! geodata->getWaypoints().empty();
+  writeHeader(xml, has_bounds, geodata->getBounds());
+
+  if (use_pipeline) {
+    for (int i = 0; i < 3; ++i) {
+      io->write(preformatted[i]);
+      preformatted[i].clear();
+    }
+    xml.writeEndElement();
+    xml.writeEndDocument();
+    return;
+  }
+
+  const std::vector<GpxItem> items = gpx_collect_items(geodata);
+  size_t points = 0;
+  for (auto&& item : items) {
+    points += item.points;
+  }
+
+  const int nthreads = formattingThreads(points);
+  if (nthreads > 1 && items.size() > 1) {
+    // the chunks are written to the device directly, the writer
+    // does not buffer so the order is kept
+    writeParallel(io, items, points, nthreads);
+  } else {
+    GpxNameCache names;
+    for (auto&& item : items) {
+      writeItem(xml, &names, item);
+    }
+  }
+
+  xml.writeEndElement();
+  xml.writeEndDocument();
+}
+
+// Start of the document up to the bounds, the root element stays open
+void
+GpxFormat::writeHeader(QXmlStreamWriter& xml, bool has_bounds, const std::pair<Waypoint, Waypoint>& bounds) const
+{
+  xml.writeStartElement(QStringLiteral("gpx"));
+  xml.writeAttribute(QStringLiteral("version"), QStringLiteral("1.0"));
+  xml.writeAttribute(QStringLiteral("creator"), creator);
+  xml.writeAttribute(QStringLiteral("xmlns"), QStringLiteral("http://www.topografix.com/GPX/1/0"));
+
+  QString time;
+  if (testmode) {
+    time = QDateTime::fromSecsSinceEpoch(0, QTimeZone("UTC")).toString(Qt::ISODate);
+  } else {
+    time = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+  }
+  xml.writeTextElement(QStringLiteral("time"), time);
+
+  if (has_bounds) {
+    const Waypoint& min = bounds.first;
+    const Waypoint& max = bounds.second;
+    xml.writeStartElement(QStringLiteral("bounds"));
+    xml.writeAttribute(QStringLiteral("minlat"), QString::number(min.latitude, 'f', coord_digits));
+    xml.writeAttribute(QStringLiteral("minlon"), QString::number(min.longitude, 'f', coord_digits));
+    xml.writeAttribute(QStringLiteral("maxlat"), QString::number(max.latitude, 'f', coord_digits));
+    xml.writeAttribute(QStringLiteral("maxlon"), QString::number(max.longitude, 'f', coord_digits));
+    xml.writeEndElement();
+  }
+}
+
+/**********************************************************************/
+
+std::vector<GpxShard>
+GpxFormat::planShards(const Geodata* geodata, const GpxSplit& split) const
+{
+  TraceSpan span("writer", "gpx shards");
+  const std::vector<GpxItem> items = gpx_collect_items(geodata);
+  std::vector<GpxShard> shards;
+  if (split.unit == GpxSplit::kBytes) {
+    shards = planShardBytes(items, split.limit);
+  } else {
+    // a track part has two points at least
+    const quint64 limit = split.unit == GpxSplit::kPoints ? std::max<quint64>(split.limit, 2) : split.limit;
+    quint64 weight = 0;
+    auto add = [&shards, &weight, limit](const GpxItem& item, quint64 item_weight) {
+      if (shards.empty() || (weight > 0 && weight + item_weight > limit)) {
+        shards.emplace_back();
+        weight = 0;
+      }
+      shards.back().items.push_back(item);
+      weight += item_weight;
+    };
+    for (auto&& item : items) {
+      if (split.unit == GpxSplit::kObjects) {
+        add(item, 1);
+        continue;
+      }
+      const size_t count = item.list ? item.list->getWaypoints().size() : 1;
+      if (item.kind != GpxItem::kTrack || count <= limit) {
+        add(item, count);
+        continue;
+      }
+      // consecutive parts share a point, so no segment is lost
+      for (size_t first = 0; first + 1 < count; first += limit - 1) {
+        GpxItem part = item;
+        part.first = first;
+        part.end = std::min<size_t>(first + limit, count);
+        part.points = part.end - part.first + 1;
+        add(part, part.end - part.first);
+      }
+    }
+  }
+  // an empty document is still written
+  if (shards.empty()) {
+    shards.emplace_back();
+  }
+  return shards;
+}
+
+// With a byte limit every item is formatted while planning, the
+// shards are then filled with the formatted bytes. The header is
+// accounted with the widest bounds possible.
+std::vector<GpxShard>
+GpxFormat::planShardBytes(const std::vector<GpxItem>& items, quint64 limit) const
+{
+  QByteArray header;
+  {
+    QXmlStreamWriter xml(&header);
+    xml.setAutoFormatting(!compact);
+    xml.setAutoFormattingIndent(2);
+    xml.writeStartDocument();
+    writeHeader(xml, true, {Waypoint(-90.0, -180.0), Waypoint(-90.0, -180.0)});
+    xml.writeEndDocument();
+  }
+  const quint64 budget = limit > quint64(header.size()) ? limit - header.size() : 1;
+
+  size_t points = 0;
+  for (auto&& item : items) {
+    points += item.points;
+  }
+  std::vector<QByteArray> formatted(items.size());
+  parallel_for(items.size(), formattingThreads(points), [&](size_t i, int) {
+    formatted[i] = formatChunk(&items[i], &items[i] + 1);
+  });
 
+  std::vector<GpxShard> shards;
+  quint64 size = 0;
+  auto add = [&shards, &size, budget](const GpxItem& item, const QByteArray& bytes) {
+    if (shards.empty() || (size > 0 && size + bytes.size() > budget)) {
+      shards.emplace_back();
+      shards.back().formatted = true;
+      size = 0;
+    }
+    shards.back().items.push_back(item);
+    shards.back().body += bytes;
+    size += bytes.size();
+  };
+  for (size_t i = 0; i < items.size(); ++i) {
+    const GpxItem& item = items[i];
+    const size_t count = item.list ? item.list->getWaypoints().size() : 1;
+    if (item.kind != GpxItem::kTrack || quint64(formatted[i].size()) <= budget || count <= 2) {
+      add(item, formatted[i]);
+      formatted[i] = QByteArray();
+      continue;
+    }
+    // cut the track into parts with the estimated number of points,
+    // parts that still do not fit are cut smaller
+    const double estimate = static_cast<double>(count) * budget / formatted[i].size();
+    const size_t part_points = std::max<size_t>(2, static_cast<size_t>(std::min<double>(estimate, count)));
+    for (size_t first = 0; first + 1 < count;) {
+      GpxItem part = item;
+      size_t n = std::min(part_points, count - first);
+      QByteArray bytes;
+      for (;;) {
+        part.first = first;
+        part.end = first + n;
+        part.points = n + 1;
+        bytes = formatChunk(&part, &part + 1);
+        if (quint64(bytes.size()) <= budget || n <= 2) {
+          break;
+        }
+        const double smaller = static_cast<double>(n) * budget / bytes.size();
+        n = std::max<size_t>(2, std::min(n - 1, static_cast<size_t>(smaller)));
+      }
+      add(part, bytes);
+      first += n - 1;
+    }
+  }
+  return shards;
+}
+
+void
+GpxFormat::writeShard(QIODevice* io, const GpxShard& shard) const
+{
+  QXmlStreamWriter xml;
+  xml.setAutoFormatting(!compact);
+  xml.setAutoFormattingIndent(2);
+  xml.setDevice(io);
+  xml.writeStartDocument();
+  writeHeader(xml, !shard.items.empty(), gpx_item_bounds(shard.items));
+  if (shard.formatted) {
+    // formatted like the pipeline output, see formatChunk()
+    io->write(shard.body);
+  } else {
+    GpxNameCache names;
+    for (auto&& item : shard.items) {
+      writeItem(xml, &names, item);
+    }
+  }
   xml.writeEndElement();
   xml.writeEndDocument();
 }
 
+// Number of threads formatting a document with the given number of
+// points: the --threads setting, or all CPUs for large documents
+int
+GpxFormat::formattingThreads(size_t points) const
+{
+  if (threads > 0) {
+    return threads;
+  }
+  if (points < kParallelMinPoints) {
+    return 1;
+  }
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
 void GpxFormat::setCreator(const QString& _creator)
 {
   creator = _creator;
@@ -131,6 +641,31 @@ void GpxFormat::setTestmode(bool _testmode)
   testmode = _testmode;
 }
 
+void GpxFormat::setCompact(bool _compact)
+{
+  compact = _compact;
+}
+
+void GpxFormat::setNameCopies(bool _name_copies)
+{
+  name_copies = _name_copies;
+}
+
+void GpxFormat::setCoordinatePrecision(int digits)
+{
+  coord_digits = digits;
+}
+
+void GpxFormat::setElevationPrecision(int digits)
+{
+  ele_digits = digits;
+}
+
+void GpxFormat::setThreads(int _threads)
+{
+  threads = _threads;
+}
+
 const QString GpxFormat::getName()
 {
   return "gpx";
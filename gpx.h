@@ -22,24 +22,131 @@
 #ifndef GPX_H_INCLUDED_
 #define GPX_H_INCLUDED_
 
+#include <QByteArray>
+#include <QHash>
 #include <QIODevice>
 #include <QString>
+#include <QXmlStreamWriter>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include "format.h"
 #include "geodata.h"
+#include "spscqueue.h"
+
+// One top level element of the document
+struct GpxItem {
+  enum Kind { kWaypoint, kRoute, kTrack } kind;
+  const Waypoint* waypoint;
+  const WaypointList* list;
+  // number of points as measure of the formatting work
+  size_t points;
+  // points first .. end - 1 of the list, less than all for a track
+  // split into shards
+  size_t first = 0;
+  size_t end = SIZE_MAX;
+};
+
+// Upper limit of a shard written by --split-by
+struct GpxSplit {
+  enum Unit { kPoints, kBytes, kObjects } unit;
+  quint64 limit;
+};
 
-class GpxFormat : public Format
+// The items of one shard document. With a byte limit the items are
+// already formatted into body while planning.
+struct GpxShard {
+  std::vector<GpxItem> items;
+  QByteArray body;
+  bool formatted = false;
+};
+
+// Escaped UTF-8 form of the names written so far. The entries are
+// keyed by the string data, so names interned by Geodata share one
+// entry and are escaped only once. Each entry keeps a reference to
+// its name, the key can therefore not be reused by another string.
+class GpxNameCache
 {
 public:
-  GpxFormat() : testmode(false) {};
+  // nullptr if the name has to be escaped by QXmlStreamWriter
+  const QByteArray* escaped(const QString& name);
+private:
+  struct Entry {
+    QString name;
+    QByteArray escaped;
+    bool valid;
+  };
+  QHash<const QChar*, Entry> entries;
+};
+
+class GpxFormat : public Format, public GeodataObserver
+{
+public:
+  GpxFormat() : testmode(false), compact(false), name_copies(true), coord_digits(kDefaultDigits), ele_digits(kDefaultDigits), threads(0), pipeline_done(false) {};
+  ~GpxFormat() override;
 
   void write(QIODevice* io, const Geodata* geodata) override;
   void setCreator(const QString& creator);
   void setTestmode(bool testmode);
+  // no indentation and line breaks
+  void setCompact(bool compact);
+  // write waypoint names to cmt and desc as well
+  void setNameCopies(bool name_copies);
+  void setCoordinatePrecision(int digits);
+  void setElevationPrecision(int digits);
+  // formatting threads, 0 uses all CPUs for large documents only
+  void setThreads(int threads);
   virtual const QString getName() override;
+
+  // Split the document into shards that stay below the limit. Tracks
+  // longer than the limit are cut into parts sharing the point at the
+  // cut, every other object is kept whole. A shard holds at least one
+  // object or track part even if that exceeds the limit.
+  std::vector<GpxShard> planShards(const Geodata* geodata, const GpxSplit& split) const;
+  // Write a shard as a document with its own bounds. Different
+  // shards can be written concurrently.
+  void writeShard(QIODevice* io, const GpxShard& shard) const;
+
+  // Pipeline mode: with the format registered as observer of the
+  // Geodata being read, completed items are formatted on a separate
+  // thread while the reader continues. write() then only adds the
+  // header with the bounds.
+  void startPipeline();
+  void waypointAdded(const Waypoint* waypoint) override;
+  void routeAdded(const WaypointList* route) override;
+  void trackAdded(const WaypointList* track) override;
+
+  static const int kDefaultDigits = 9;
+  static const int kMaxDigits = 15;
 private:
+  void writeHeader(QXmlStreamWriter& xml, bool has_bounds, const std::pair<Waypoint, Waypoint>& bounds) const;
+  std::vector<GpxShard> planShardBytes(const std::vector<GpxItem>& items, quint64 limit) const;
+  void writeItem(QXmlStreamWriter& xml, GpxNameCache* names, const GpxItem& item) const;
+  QByteArray formatChunk(const GpxItem* begin, const GpxItem* end) const;
+  void writeParallel(QIODevice* io, const std::vector<GpxItem>& items, size_t points, int nthreads) const;
+  int formattingThreads(size_t points) const;
+  void pushItem(GpxItem item);
+  void runPipeline();
+  bool finishPipeline(const Geodata* geodata);
+
   QString creator;
   bool testmode;
+  bool compact;
+  bool name_copies;
+  int coord_digits;
+  int ele_digits;
+  int threads;
+
+  std::unique_ptr<SpscQueue<GpxItem>> pipeline_queue;
+  std::thread pipeline_thread;
+  std::atomic<bool> pipeline_done;
+  // formatted items and their count per GpxItem::Kind
+  QByteArray preformatted[3];
+  size_t preformatted_count[3];
 };
 
 #endif
@@ -0,0 +1,359 @@
+/*
+
+    Batched reading of many small input files
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <QDebug>
+#include <QFile>
+
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include "ingest.h"
+#include "trace.h"
+
+// the readers are limited to files addressable with 32 bit offsets
+static constexpr qint64 kMaxFileSize = INT32_MAX;
+
+struct BatchIngest::Entry {
+  enum State {kIdle, kOpening, kReading, kClosing, kDone};
+
+  QByteArray path;
+  QByteArray data;
+  State state = kIdle;
+  int fd = -1;
+  int pending = 0;
+  int error = 0;
+  qint64 size = 0;
+  qint64 done = 0;
+#ifdef HAVE_LIBURING
+  struct statx stx;
+#endif
+};
+
+#ifdef HAVE_LIBURING
+struct BatchIngest::Ring {
+  struct io_uring uring;
+};
+
+// largest length of a single read request
+static constexpr qint64 kMaxReadSize = 1 << 30;
+
+// user_data of a request: slot index and operation
+enum IngestOp {kOpOpen, kOpStat, kOpRead, kOpClose, kOpCount};
+
+static quint64
+ingest_user_data(int slot, IngestOp op)
+{
+  return static_cast<quint64>(slot) * kOpCount + op;
+}
+
+static bool
+ingest_uring_supported(struct io_uring* uring)
+{
+  struct io_uring_probe* probe = io_uring_get_probe_ring(uring);
+  if (!probe) {
+    return false;
+  }
+  bool supported = io_uring_opcode_supported(probe, IORING_OP_OPENAT) &&
+                   io_uring_opcode_supported(probe, IORING_OP_STATX) &&
+                   io_uring_opcode_supported(probe, IORING_OP_READ) &&
+                   io_uring_opcode_supported(probe, IORING_OP_CLOSE);
+  io_uring_free_probe(probe);
+  return supported;
+}
+
+static struct io_uring_sqe*
+ingest_get_sqe(struct io_uring* uring)
+{
+  struct io_uring_sqe* sqe = io_uring_get_sqe(uring);
+  while (!sqe) {
+    // the queue is full, hand the requests to the kernel
+    io_uring_submit(uring);
+    sqe = io_uring_get_sqe(uring);
+  }
+  return sqe;
+}
+#else
+struct BatchIngest::Ring {
+};
+#endif
+
+/**********************************************************************/
+
+BatchIngest::BatchIngest(const QStringList& _filenames, int _inflight) :
+  filenames(_filenames), inflight(qMax(1, _inflight)), next_submit(0), next_result(0)
+{
+#ifdef HAVE_LIBURING
+  auto r = std::make_unique<Ring>();
+  // every file has at most two requests queued at the same time
+  if (io_uring_queue_init(2 * inflight, &r->uring, 0) == 0) {
+    if (ingest_uring_supported(&r->uring)) {
+      ring = std::move(r);
+    } else {
+      io_uring_queue_exit(&r->uring);
+    }
+  }
+#endif
+  entries.resize(ring ? inflight : 1);
+}
+
+BatchIngest::~BatchIngest()
+{
+#ifdef HAVE_LIBURING
+  if (ring) {
+    // the kernel may still write into the buffers of queued requests
+    for (;;) {
+      bool busy = false;
+      for (auto&& entry : entries) {
+        busy = busy || (entry.state != Entry::kIdle && entry.state != Entry::kDone);
+      }
+      if (!busy) {
+        break;
+      }
+      complete();
+    }
+    io_uring_queue_exit(&ring->uring);
+  }
+#endif
+}
+
+bool
+BatchIngest::usesUring() const
+{
+  return ring != nullptr;
+}
+
+bool
+BatchIngest::next(QString* filename, QByteArray* data, int* error)
+{
+  if (next_result >= filenames.size()) {
+    return false;
+  }
+  TraceSpan span("ingest", "next");
+
+  Entry* entry;
+  if (ring) {
+    submit();
+    entry = &entries[next_result % inflight];
+    while (entry->state != Entry::kDone) {
+      complete();
+    }
+  } else {
+    entry = &entries.front();
+    entry->path = QFile::encodeName(filenames.at(next_result));
+    readDirect(entry);
+  }
+
+  *filename = filenames.at(next_result);
+  *data = std::move(entry->data);
+  *error = entry->error;
+  entry->data = QByteArray();
+  entry->state = Entry::kIdle;
+  next_result++;
+
+  // queue the following files, they are read while this one is
+  // converted
+  if (ring) {
+    submit();
+  }
+  return true;
+}
+
+// Fallback without io_uring: the minimal number of system calls,
+// one read of the whole file if it does not change while reading
+void
+BatchIngest::readDirect(Entry* entry)
+{
+  entry->error = 0;
+  entry->data = QByteArray();
+  int fd = ::open(entry->path.constData(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    entry->error = errno;
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    entry->error = errno;
+  } else if (st.st_size > kMaxFileSize) {
+    entry->error = EFBIG;
+  } else {
+    entry->data.resize(static_cast<qsizetype>(st.st_size));
+    qint64 done = 0;
+    while (done < entry->data.size()) {
+      ssize_t len = ::read(fd, entry->data.data() + done, entry->data.size() - done);
+      if (len < 0 && errno == EINTR) {
+        continue;
+      }
+      if (len < 0) {
+        entry->error = errno;
+        break;
+      }
+      if (len == 0) {
+        // truncated while reading
+        entry->data.truncate(done);
+        break;
+      }
+      done += len;
+    }
+  }
+  ::close(fd);
+}
+
+// Queue open and stat of the next files until <inflight> files are
+// in progress
+void
+BatchIngest::submit()
+{
+#ifdef HAVE_LIBURING
+  struct io_uring* uring = &ring->uring;
+  bool queued = false;
+  while (next_submit < filenames.size() && next_submit - next_result < inflight) {
+    const int slot = next_submit % inflight;
+    Entry* entry = &entries[slot];
+    entry->path = QFile::encodeName(filenames.at(next_submit));
+    entry->data = QByteArray();
+    entry->state = Entry::kOpening;
+    entry->fd = -1;
+    entry->error = 0;
+    entry->size = 0;
+    entry->done = 0;
+    entry->pending = 2;
+
+    struct io_uring_sqe* sqe = ingest_get_sqe(uring);
+    io_uring_prep_openat(sqe, AT_FDCWD, entry->path.constData(), O_RDONLY | O_CLOEXEC, 0);
+    io_uring_sqe_set_data64(sqe, ingest_user_data(slot, kOpOpen));
+    sqe = ingest_get_sqe(uring);
+    io_uring_prep_statx(sqe, AT_FDCWD, entry->path.constData(), 0, STATX_SIZE, &entry->stx);
+    io_uring_sqe_set_data64(sqe, ingest_user_data(slot, kOpStat));
+
+    next_submit++;
+    queued = true;
+  }
+  if (queued) {
+    io_uring_submit(uring);
+  }
+#endif
+}
+
+// Wait for at least one completion and advance the files the
+// completions belong to
+void
+BatchIngest::complete()
+{
+#ifdef HAVE_LIBURING
+  struct io_uring* uring = &ring->uring;
+  struct io_uring_cqe* cqe;
+  int ret = io_uring_wait_cqe(uring, &cqe);
+  if (ret == -EINTR) {
+    return;
+  }
+  if (ret < 0) {
+    qCritical() << "error: io_uring_wait_cqe failed:" << -ret;
+    exit(1);
+  }
+
+  unsigned head;
+  unsigned count = 0;
+  io_uring_for_each_cqe(uring, head, cqe) {
+    count++;
+    const quint64 user_data = io_uring_cqe_get_data64(cqe);
+    const int slot = static_cast<int>(user_data / kOpCount);
+    const auto op = static_cast<IngestOp>(user_data % kOpCount);
+    Entry* entry = &entries[slot];
+    const int res = cqe->res;
+
+    switch (op) {
+    case kOpOpen:
+      if (res < 0) {
+        entry->error = -res;
+      } else {
+        entry->fd = res;
+      }
+      break;
+    case kOpStat:
+      if (res < 0) {
+        entry->error = -res;
+      } else {
+        entry->size = static_cast<qint64>(entry->stx.stx_size);
+      }
+      break;
+    case kOpRead:
+      if (res == -EINTR || res == -EAGAIN) {
+        // retried below
+      } else if (res < 0) {
+        entry->error = -res;
+      } else if (res == 0) {
+        // truncated while reading
+        entry->data.truncate(entry->done);
+        entry->size = entry->done;
+      } else {
+        entry->done += res;
+      }
+      break;
+    case kOpClose:
+      break;
+    case kOpCount:
+      break;
+    }
+    entry->pending--;
+    if (entry->pending > 0) {
+      continue;
+    }
+
+    // all requests of the current state are done, queue the next one
+    if (entry->state == Entry::kOpening && entry->error == 0 && entry->size > kMaxFileSize) {
+      entry->error = EFBIG;
+    }
+    if (entry->state == Entry::kOpening && entry->error == 0) {
+      entry->state = Entry::kReading;
+      entry->data.resize(static_cast<qsizetype>(entry->size));
+    }
+    if (entry->state == Entry::kReading && entry->error == 0 && entry->done < entry->size) {
+      const qint64 len = qMin(entry->size - entry->done, kMaxReadSize);
+      struct io_uring_sqe* sqe = ingest_get_sqe(uring);
+      io_uring_prep_read(sqe, entry->fd, entry->data.data() + entry->done, static_cast<unsigned>(len), entry->done);
+      io_uring_sqe_set_data64(sqe, ingest_user_data(slot, kOpRead));
+      entry->pending = 1;
+    } else if (entry->state != Entry::kClosing && entry->fd >= 0) {
+      entry->state = Entry::kClosing;
+      struct io_uring_sqe* sqe = ingest_get_sqe(uring);
+      io_uring_prep_close(sqe, entry->fd);
+      io_uring_sqe_set_data64(sqe, ingest_user_data(slot, kOpClose));
+      entry->fd = -1;
+      entry->pending = 1;
+    } else {
+      if (entry->error != 0) {
+        entry->data = QByteArray();
+      }
+      entry->state = Entry::kDone;
+    }
+  }
+  io_uring_cq_advance(uring, count);
+  io_uring_submit(uring);
+#endif
+}
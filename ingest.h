@@ -0,0 +1,73 @@
+/*
+
+    Batched reading of many small input files
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef INGEST_H_INCLUDED_
+#define INGEST_H_INCLUDED_
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <vector>
+
+// Reads whole files into memory for the batch mode. With io_uring
+// the open, stat, read and close requests of up to <inflight> files
+// are queued to the kernel at once, so the files are read while the
+// previous ones are converted. Without io_uring (not compiled in or
+// blocked by the kernel) every file is read with open, fstat, read
+// and close when it is needed. Files are returned in the order of
+// the list.
+class BatchIngest
+{
+public:
+  BatchIngest(const QStringList& filenames, int inflight);
+  ~BatchIngest();
+
+  BatchIngest(const BatchIngest&) = delete;
+  BatchIngest& operator=(const BatchIngest&) = delete;
+  BatchIngest(BatchIngest&&) = delete;
+  BatchIngest& operator=(BatchIngest&&) = delete;
+
+  // Returns false after the last file. On success data holds the
+  // file contents, otherwise error is an errno value.
+  bool next(QString* filename, QByteArray* data, int* error);
+  bool usesUring() const;
+
+  static constexpr int kDefaultInflight = 32;
+private:
+  struct Entry;
+  struct Ring;
+
+  void readDirect(Entry* entry);
+  void submit();
+  void complete();
+
+  QStringList filenames;
+  int inflight;
+  int next_submit;
+  int next_result;
+  std::vector<Entry> entries;
+  std::unique_ptr<Ring> ring;
+};
+
+#endif
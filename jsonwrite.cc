@@ -0,0 +1,110 @@
+/*
+
+    Number and string output for the JSON writers
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <charconv>
+#include <cmath>
+
+#include "jsonwrite.h"
+
+static void
+jsonwrite_trimmed(QByteArray& out, const char* begin, const char* end, int digits)
+{
+  if (digits > 0) {
+    while (end[-1] == '0') {
+      --end;
+    }
+    if (end[-1] == '.') {
+      --end;
+    }
+  }
+  out.append(begin, end - begin);
+}
+
+void
+jsonwrite_number(QByteArray& out, double value, int digits)
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  char buf[64];
+  auto res = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, digits);
+  if (res.ec == std::errc()) {
+    jsonwrite_trimmed(out, buf, res.ptr, digits);
+    return;
+  }
+#endif
+  // floating point to_chars is not available in this library, or the
+  // number does not fit the buffer
+  const QByteArray text = QByteArray::number(value, 'f', digits);
+  jsonwrite_trimmed(out, text.constData(), text.constData() + text.size(), digits);
+}
+
+void
+jsonwrite_value(QByteArray& out, double value, int digits)
+{
+  if (std::isfinite(value)) {
+    jsonwrite_number(out, value, digits);
+  } else {
+    out += "null";
+  }
+}
+
+void
+jsonwrite_string(QByteArray& out, const QString& str)
+{
+  static const char hex[] = "0123456789abcdef";
+  const QByteArray utf8 = str.toUtf8();
+  const char* p = utf8.constData();
+  const char* end = p + utf8.size();
+  const char* run = p;
+  out += '"';
+  for (; p < end; ++p) {
+    const unsigned char c = static_cast<unsigned char>(*p);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    out.append(run, p - run);
+    run = p + 1;
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      out += "\\u00";
+      out += hex[c >> 4];
+      out += hex[c & 0x0f];
+      break;
+    }
+  }
+  out.append(run, end - run);
+  out += '"';
+}
@@ -0,0 +1,40 @@
+/*
+
+    Number and string output for the JSON writers
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef JSONWRITE_H_INCLUDED_
+#define JSONWRITE_H_INCLUDED_
+
+#include <QByteArray>
+#include <QString>
+
+// Number with the given digits after the point, trailing zeros
+// removed. The value must be finite, JSON has no representation of
+// NaN and infinity. The same format is used for CSV.
+void jsonwrite_number(QByteArray& out, double value, int digits);
+
+// Number, or null for NaN and infinity
+void jsonwrite_value(QByteArray& out, double value, int digits);
+
+// Quoted string in UTF-8 with the characters JSON requires escaped
+void jsonwrite_string(QByteArray& out, const QString& str);
+
+#endif
@@ -0,0 +1,198 @@
+/*
+
+    Merging of several overlays with removal of duplicates
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "merge.h"
+
+#include <cmath>
+#include <utility>
+
+#include "cache.h"
+
+// Equal values must hash equal, so fold -0 into 0 and every NaN into
+// one bit pattern
+static double
+merge_canonical(double value)
+{
+  if (std::isnan(value)) {
+    return NAN;
+  }
+  return value == 0.0 ? 0.0 : value;
+}
+
+static bool
+merge_same(double a, double b)
+{
+  return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+static bool
+merge_same_waypoint(const Waypoint& a, const Waypoint& b)
+{
+  return merge_same(a.latitude, b.latitude) &&
+         merge_same(a.longitude, b.longitude) &&
+         merge_same(a.elevation, b.elevation) &&
+         a.name == b.name;
+}
+
+static bool
+merge_same_list(const WaypointList& a, const WaypointList& b)
+{
+  if (a.name != b.name) {
+    return false;
+  }
+  const auto& pa = a.getWaypoints();
+  const auto& pb = b.getWaypoints();
+  if (pa.size() != pb.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < pa.size(); ++i) {
+    if (!merge_same_waypoint(pa[i], pb[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static quint64
+merge_hash_name(const QString& name, quint64 seed)
+{
+  return ConversionCache::hash(reinterpret_cast<const char*>(name.constData()),
+                               size_t(name.size()) * sizeof(QChar), seed);
+}
+
+static quint64
+merge_hash_waypoint(const Waypoint& waypoint)
+{
+  const double values[3] = {
+    merge_canonical(waypoint.latitude),
+    merge_canonical(waypoint.longitude),
+    merge_canonical(waypoint.elevation)
+  };
+  return ConversionCache::hash(reinterpret_cast<const char*>(values), sizeof(values),
+                               merge_hash_name(waypoint.name, 0));
+}
+
+static bool
+merge_finite(const Waypoint& waypoint)
+{
+  return std::isfinite(waypoint.latitude) && std::isfinite(waypoint.longitude);
+}
+
+GeodataMerger::GeodataMerger(Geodata* _target, double _tolerance)
+  : target(_target), tolerance(_tolerance), removed(0), grid(_tolerance)
+{
+}
+
+// Hash of the name and the points of a list. The coordinates are
+// copied to one array, so they are hashed in a single pass.
+quint64
+GeodataMerger::hashList(const WaypointList& list)
+{
+  const auto& points = list.getWaypoints();
+  scratch.clear();
+  scratch.reserve(points.size() * 3);
+  quint64 seed = merge_hash_name(list.name, points.size());
+  for (const auto& point : points) {
+    scratch.push_back(merge_canonical(point.latitude));
+    scratch.push_back(merge_canonical(point.longitude));
+    scratch.push_back(merge_canonical(point.elevation));
+    if (!point.name.isEmpty()) {
+      seed = merge_hash_name(point.name, seed);
+    }
+  }
+  return ConversionCache::hash(reinterpret_cast<const char*>(scratch.data()),
+                               scratch.size() * sizeof(double), seed);
+}
+
+bool
+GeodataMerger::isNearDuplicate(const Waypoint& waypoint)
+{
+  const auto& waypoints = target->getWaypoints();
+  candidates.clear();
+  grid.query(waypoint, &candidates);
+  for (size_t index : candidates) {
+    const Waypoint& other = waypoints[index];
+    if (other.name == waypoint.name && GeoGrid::distance(waypoint, other) <= tolerance) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+GeodataMerger::add(Geodata* source)
+{
+  const bool near = tolerance > 0.0;
+
+  for (auto& waypoint : source->getWaypoints()) {
+    const quint64 hash = merge_hash_waypoint(waypoint);
+    auto range = waypoint_hashes.equal_range(hash);
+    bool duplicate = false;
+    for (auto it = range.first; it != range.second && !duplicate; ++it) {
+      duplicate = merge_same_waypoint(target->getWaypoints()[it->second], waypoint);
+    }
+    const bool finite = merge_finite(waypoint);
+    if (!duplicate && near && finite) {
+      duplicate = isNearDuplicate(waypoint);
+    }
+    if (duplicate) {
+      removed++;
+      continue;
+    }
+    const size_t index = target->getWaypoints().size();
+    target->addWaypoint(std::move(waypoint));
+    waypoint_hashes.emplace(hash, index);
+    if (near && finite) {
+      grid.insert(target->getWaypoints()[index], index);
+    }
+  }
+  source->getWaypoints().clear();
+
+  auto merge_lists = [this](std::deque<WaypointList>& lists,
+                            std::unordered_multimap<quint64, size_t>& hashes,
+                            const std::deque<WaypointList>& targets,
+                            void (Geodata::*append)(WaypointList&&)) {
+    for (auto& list : lists) {
+      const quint64 hash = hashList(list);
+      auto range = hashes.equal_range(hash);
+      bool duplicate = false;
+      for (auto it = range.first; it != range.second && !duplicate; ++it) {
+        duplicate = merge_same_list(targets[it->second], list);
+      }
+      if (duplicate) {
+        removed++;
+        continue;
+      }
+      hashes.emplace(hash, targets.size());
+      (target->*append)(std::move(list));
+    }
+    lists.clear();
+  };
+  merge_lists(source->getRoutes(), route_hashes, target->getRoutes(), &Geodata::addRoute);
+  merge_lists(source->getTracks(), track_hashes, target->getTracks(), &Geodata::addTrack);
+}
+
+size_t
+GeodataMerger::duplicates() const
+{
+  return removed;
+}
@@ -0,0 +1,73 @@
+/*
+
+    Merging of several overlays with removal of duplicates
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef MERGE_H_INCLUDED_
+#define MERGE_H_INCLUDED_
+
+#include <QtGlobal>
+
+#include <unordered_map>
+#include <vector>
+
+#include "geodata.h"
+#include "geogrid.h"
+
+// Moves the objects of several Geodata into one and drops objects
+// equal to one added before: waypoints with the same coordinates and
+// name, routes and tracks with the same name and points. Objects are
+// found by a hash of their content, so merging is linear in the
+// number of points. With a tolerance, waypoints with the same name
+// closer than tolerance meters to a waypoint added before are dropped
+// as well. They are found with a hash grid of cells of the size of
+// the tolerance.
+class GeodataMerger
+{
+public:
+  GeodataMerger(Geodata* target, double tolerance);
+
+  GeodataMerger(const GeodataMerger&) = delete;
+  GeodataMerger& operator=(const GeodataMerger&) = delete;
+  GeodataMerger(GeodataMerger&&) = delete;
+  GeodataMerger& operator=(GeodataMerger&&) = delete;
+
+  // Move the objects of source to the target, source is left empty
+  void add(Geodata* source);
+  // number of objects dropped so far
+  size_t duplicates() const;
+private:
+  quint64 hashList(const WaypointList& list);
+  bool isNearDuplicate(const Waypoint& waypoint);
+
+  Geodata* target;
+  double tolerance;
+  size_t removed;
+  std::vector<double> scratch;
+  std::vector<size_t> candidates;
+  // content hash to index in the target
+  std::unordered_multimap<quint64, size_t> waypoint_hashes;
+  std::unordered_multimap<quint64, size_t> route_hashes;
+  std::unordered_multimap<quint64, size_t> track_hashes;
+  // indices of the waypoints in the target
+  GeoGrid grid;
+};
+
+#endif
@@ -0,0 +1,84 @@
+/*
+
+    Allocation free parsing of numbers in overlay files
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef NUMPARSE_H_INCLUDED_
+#define NUMPARSE_H_INCLUDED_
+
+#include <QString>
+
+#include <charconv>
+#include <system_error>
+
+// The functions parse plain ASCII numbers with std::from_chars, which
+// does not depend on the locale and rounds correctly like the Qt
+// conversions. They return false unless the whole text is a number,
+// the callers then use the Qt conversion, so signs, whitespace and
+// invalid input are handled exactly as before.
+
+inline bool
+numparse_double(const char* begin, const char* end, double* value)
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  // leave inf and nan to Qt, it accepts other spellings
+  const char* first = begin < end && *begin == '-' ? begin + 1 : begin;
+  if (first == end || !((*first >= '0' && *first <= '9') || *first == '.')) {
+    return false;
+  }
+  auto res = std::from_chars(begin, end, *value);
+  return res.ec == std::errc() && res.ptr == end;
+#else
+  // floating point from_chars is not available in this library
+  (void)begin;
+  (void)end;
+  (void)value;
+  return false;
+#endif
+}
+
+inline bool
+numparse_int(const char* begin, const char* end, int* value)
+{
+  auto res = std::from_chars(begin, end, *value);
+  return res.ec == std::errc() && res.ptr == end;
+}
+
+// Number stored in a QString, e.g. an XML attribute
+inline bool
+numparse_double(const QString& text, double* value)
+{
+  char buf[64];
+  const qsizetype len = text.size();
+  if (len == 0 || len > qsizetype(sizeof(buf))) {
+    return false;
+  }
+  const QChar* data = text.constData();
+  for (qsizetype i = 0; i < len; ++i) {
+    const char16_t c = data[i].unicode();
+    if (c > 0x7f) {
+      return false;
+    }
+    buf[i] = static_cast<char>(c);
+  }
+  return numparse_double(buf, buf + len, value);
+}
+
+#endif
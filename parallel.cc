@@ -0,0 +1,69 @@
+/*
+
+    Parallel loop over the items of a list
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "allocstats.h"
+#include "parallel.h"
+
+int
+parallel_threads(int threads, size_t count)
+{
+  if (threads <= 0) {
+    threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  return static_cast<int>(std::max<size_t>(1, std::min<size_t>(threads, count)));
+}
+
+void
+parallel_for(size_t count, int threads, const std::function<void(size_t, int)>& fn)
+{
+  const int nthreads = parallel_threads(threads, count);
+  std::atomic<size_t> next(0);
+  // allocations of the pool threads, added to the caller after the
+  // join so that they count for the phase that runs the loop
+  std::vector<AllocCount> allocs(nthreads - 1);
+  auto worker = [&next, &allocs, count, &fn](int id) {
+    AllocCounter counter;
+    for (size_t i = next++; i < count; i = next++) {
+      fn(i, id);
+    }
+    if (id > 0) {
+      allocs[id - 1] = counter.delta();
+    }
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(nthreads - 1);
+  for (int id = 1; id < nthreads; ++id) {
+    pool.emplace_back(worker, id);
+  }
+  worker(0);
+  for (auto&& thread : pool) {
+    thread.join();
+  }
+  for (auto&& count : allocs) {
+    AllocStats::add(count);
+  }
+}
@@ -0,0 +1,40 @@
+/*
+
+    Parallel loop over the items of a list
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef PARALLEL_H_INCLUDED_
+#define PARALLEL_H_INCLUDED_
+
+#include <cstddef>
+#include <functional>
+
+// Number of threads parallel_for() uses for count items: threads if
+// positive, otherwise one per CPU, but never more than items.
+int parallel_threads(int threads, size_t count);
+
+// Call fn(index, worker) for every index below count on
+// parallel_threads(threads, count) threads, the calling thread being
+// worker 0. Indices are handed out one at a time in increasing order,
+// so items of different cost are balanced. Returns when all calls are
+// done.
+void parallel_for(size_t count, int threads, const std::function<void(size_t, int)>& fn);
+
+#endif
@@ -0,0 +1,141 @@
+/*
+
+    Hardware performance counters (Linux perf_event_open)
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+#include "perfcounters.h"
+
+#ifdef __linux__
+
+static int
+perf_counters_open(quint64 config)
+{
+  struct perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = 1;
+  // user space only works with the default perf_event_paranoid=2
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // threads started by the calling thread add their counts when
+  // they exit, which covers workers joined within a phase
+  attr.inherit = 1;
+  // pid = 0, cpu = -1: calling thread on any CPU
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+PerfCounters::PerfCounters()
+{
+  static const quint64 config[PERF_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+  };
+  for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    fd[i] = perf_counters_open(config[i]);
+  }
+  for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    if (fd[i] >= 0) {
+      ioctl(fd[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+}
+
+PerfCounters::~PerfCounters()
+{
+  for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    if (fd[i] >= 0) {
+      close(fd[i]);
+    }
+  }
+}
+
+PerfCount
+PerfCounters::stop()
+{
+  PerfCount res;
+  for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    if (fd[i] >= 0) {
+      ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+  for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    quint64 value = 0;
+    res.valid[i] = fd[i] >= 0 && read(fd[i], &value, sizeof(value)) == sizeof(value);
+    res.value[i] = res.valid[i] ? value : 0;
+  }
+  return res;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+{
+  for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    fd[i] = -1;
+  }
+}
+
+PerfCounters::~PerfCounters()
+{
+}
+
+PerfCount
+PerfCounters::stop()
+{
+  PerfCount res;
+  for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    res.valid[i] = false;
+    res.value[i] = 0;
+  }
+  return res;
+}
+
+#endif
+
+const char*
+PerfCounters::getName(int counter)
+{
+  switch (counter) {
+  case PERF_CYCLES:
+    return "cycles";
+  case PERF_INSTRUCTIONS:
+    return "instructions";
+  case PERF_CACHE_MISSES:
+    return "cache-misses";
+  case PERF_BRANCH_MISSES:
+    return "branch-misses";
+  default:
+    return "";
+  }
+}
@@ -0,0 +1,63 @@
+/*
+
+    Hardware performance counters (Linux perf_event_open)
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef PERFCOUNTERS_H_INCLUDED_
+#define PERFCOUNTERS_H_INCLUDED_
+
+#include <QtGlobal>
+
+enum PerfCounterType {
+  PERF_CYCLES = 0,
+  PERF_INSTRUCTIONS,
+  PERF_CACHE_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_COUNTER_COUNT
+};
+
+struct PerfCount {
+  // a counter is invalid if it could not be opened (no PMU access
+  // in containers, perf_event_paranoid, non-Linux systems)
+  bool valid[PERF_COUNTER_COUNT];
+  quint64 value[PERF_COUNTER_COUNT];
+};
+
+// Counts user space events of the calling thread and of the threads
+// it starts and joins between construction and stop(). Counters that are not available are
+// marked invalid instead of failing.
+class PerfCounters
+{
+public:
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+  PerfCounters(PerfCounters&&) = delete;
+  PerfCounters& operator=(PerfCounters&&) = delete;
+
+  PerfCount stop();
+  static const char* getName(int counter);
+private:
+  int fd[PERF_COUNTER_COUNT];
+};
+
+#endif
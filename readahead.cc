@@ -0,0 +1,170 @@
+/*
+
+    Read-ahead input device
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <QByteArray>
+
+#include <cstring>
+
+#include "readahead.h"
+#include "trace.h"
+
+// chunk size of the read-ahead thread
+static const qint64 kChunkSize = 1024 * 1024;
+// chunks read ahead of the decoder
+static const size_t kQueuedChunks = 16;
+
+ReadAheadDevice::ReadAheadDevice(const QString& filename) :
+  file(filename), file_size(0), eof(false), error(false), failed(false), queue(kQueuedChunks), stop(false)
+{
+}
+
+ReadAheadDevice::~ReadAheadDevice()
+{
+  close();
+}
+
+bool
+ReadAheadDevice::open(OpenMode mode)
+{
+  if ((mode & QIODevice::WriteOnly) || !file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  file_size = file.size();
+  buffer.reserve(file_size);
+  eof = false;
+  error = false;
+  failed = false;
+  stop = false;
+  reader = std::thread(&ReadAheadDevice::run, this);
+  // the data is kept in buffer, another QIODevice buffer would only
+  // copy it once more
+  return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void
+ReadAheadDevice::close()
+{
+  if (!isOpen()) {
+    return;
+  }
+  stop = true;
+  reader.join();
+  file.close();
+  buffer = QByteArray();
+  QIODevice::close();
+}
+
+bool
+ReadAheadDevice::isSequential() const
+{
+  return false;
+}
+
+qint64
+ReadAheadDevice::size() const
+{
+  return file_size;
+}
+
+bool
+ReadAheadDevice::atEnd() const
+{
+  return pos() >= file_size;
+}
+
+bool
+ReadAheadDevice::hasError() const
+{
+  return error;
+}
+
+// read-ahead thread: an empty chunk marks the end of the file, or of
+// the data read before an error
+void
+ReadAheadDevice::run()
+{
+  TraceSpan span("reader", "read ahead", file.fileName());
+  qint64 total = 0;
+  for (;;) {
+    QByteArray chunk = file.read(kChunkSize);
+    const bool last = chunk.isEmpty();
+    total += chunk.size();
+    if (last && (file.error() != QFileDevice::NoError || total < file_size)) {
+      failed = true;
+    }
+    int spins = 0;
+    while (!queue.tryPush(chunk)) {
+      if (stop) {
+        return;
+      }
+      SpscQueue<QByteArray>::backoff(spins);
+    }
+    if (last) {
+      return;
+    }
+  }
+}
+
+// take chunks from the queue until end bytes are available
+void
+ReadAheadDevice::fetch(qint64 end)
+{
+  int spins = 0;
+  while (!eof && buffer.size() < end) {
+    QByteArray chunk;
+    if (!queue.tryPop(chunk)) {
+      SpscQueue<QByteArray>::backoff(spins);
+      continue;
+    }
+    spins = 0;
+    if (chunk.isEmpty()) {
+      eof = true;
+      if (failed) {
+        error = true;
+        setErrorString(file.error() != QFileDevice::NoError ? file.errorString() : QStringLiteral("file truncated"));
+      }
+    } else {
+      buffer += chunk;
+    }
+  }
+}
+
+qint64
+ReadAheadDevice::readData(char* data, qint64 maxlen)
+{
+  const qint64 start = pos();
+  fetch(start + maxlen);
+  const qint64 len = qBound<qint64>(0, buffer.size() - start, maxlen);
+  if (len == 0 && error) {
+    return -1;
+  }
+  if (len > 0) {
+    std::memcpy(data, buffer.constData() + start, len);
+  }
+  return len;
+}
+
+qint64
+ReadAheadDevice::writeData([[maybe_unused]] const char* data, [[maybe_unused]] qint64 len)
+{
+  return -1;
+}
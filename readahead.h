@@ -0,0 +1,79 @@
+/*
+
+    Read-ahead input device
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef READAHEAD_H_INCLUDED_
+#define READAHEAD_H_INCLUDED_
+
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+
+#include <atomic>
+#include <thread>
+
+#include "spscqueue.h"
+
+// Read-only device for a regular file that is read by a separate
+// thread in large chunks, so slow media (NFS, optical) are read
+// while the reader decodes the data already available. The data
+// read so far is kept, so the readers can reset() and seek() as with
+// a QFile. A failed read or a file shorter than its size at open()
+// is an error: readData() returns -1 once the data read before it is
+// consumed, and hasError() is true.
+class ReadAheadDevice : public QIODevice
+{
+public:
+  explicit ReadAheadDevice(const QString& filename);
+  ~ReadAheadDevice() override;
+
+  ReadAheadDevice(const ReadAheadDevice&) = delete;
+  ReadAheadDevice& operator=(const ReadAheadDevice&) = delete;
+  ReadAheadDevice(ReadAheadDevice&&) = delete;
+  ReadAheadDevice& operator=(ReadAheadDevice&&) = delete;
+
+  bool open(OpenMode mode) override;
+  void close() override;
+  bool isSequential() const override;
+  qint64 size() const override;
+  bool atEnd() const override;
+  bool hasError() const;
+protected:
+  qint64 readData(char* data, qint64 maxlen) override;
+  qint64 writeData(const char* data, qint64 len) override;
+private:
+  void run();
+  void fetch(qint64 end);
+
+  QFile file;
+  qint64 file_size;
+  QByteArray buffer;
+  bool eof;
+  bool error;
+  // set by the read-ahead thread before it queues the end marker
+  std::atomic<bool> failed;
+  SpscQueue<QByteArray> queue;
+  std::thread reader;
+  std::atomic<bool> stop;
+};
+
+#endif
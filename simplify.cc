@@ -0,0 +1,173 @@
+/*
+
+    Track and route simplification (Douglas-Peucker)
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "simplify.h"
+
+static const double kEarthRadius = 6371000.0;
+// Longer lists are simplified in runs of this many points, the ends
+// of the runs are kept. Douglas-Peucker is quadratic when the splits
+// are one-sided, as on a spiral where the farthest point is always
+// on the last turn; the runs bound the work to kMaxRunPoints per
+// point.
+static const size_t kMaxRunPoints = 1024;
+
+// Scratch buffers reused for all lists to avoid allocations per track
+struct SimplifyBuffers {
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> dist;
+  std::vector<std::pair<size_t, size_t>> stack;
+  std::vector<bool> keep;
+};
+
+// Project the points to a local equirectangular plane in meters. The
+// error is negligible for the extent of a single overlay and allows
+// the distance loop below to work on plain contiguous arrays.
+static void
+simplify_project(const WaypointList* list, SimplifyBuffers& buf)
+{
+  const size_t n = list->getWaypoints().size();
+  buf.x.resize(n);
+  buf.y.resize(n);
+
+  double lat0 = 0.0;
+  double lon0 = 0.0;
+  if (n > 0) {
+    lat0 = list->getWaypoints().front().latitude;
+    lon0 = list->getWaypoints().front().longitude;
+  }
+  const double deg = M_PI / 180.0;
+  const double kx = kEarthRadius * deg * std::cos(lat0 * deg);
+  const double ky = kEarthRadius * deg;
+
+  size_t i = 0;
+  for (auto&& waypoint : list->getWaypoints()) {
+    buf.x[i] = (waypoint.longitude - lon0) * kx;
+    buf.y[i] = (waypoint.latitude - lat0) * ky;
+    ++i;
+  }
+}
+
+// Squared distance of the points first+1 .. last-1 to the segment
+// from first to last. The projection onto the line is clamped to the
+// segment, so the turnaround of a line returning close to its start
+// is not taken for a point on it. A degenerated segment (closed line)
+// has inv 0 and gives the distance to first. Branch free over
+// contiguous arrays so that the compiler can vectorize it.
+static void
+simplify_distances(SimplifyBuffers& buf, size_t first, size_t last)
+{
+  const double* x = buf.x.data();
+  const double* y = buf.y.data();
+  double* dist = buf.dist.data();
+
+  const double ax = x[first];
+  const double ay = y[first];
+  const double dx = x[last] - ax;
+  const double dy = y[last] - ay;
+  const double len2 = dx * dx + dy * dy;
+  const double inv = len2 > 0.0 ? 1.0 / len2 : 0.0;
+
+  for (size_t i = first + 1; i < last; ++i) {
+    const double px = x[i] - ax;
+    const double py = y[i] - ay;
+    const double t = std::clamp((px * dx + py * dy) * inv, 0.0, 1.0);
+    const double ex = px - t * dx;
+    const double ey = py - t * dy;
+    dist[i] = ex * ex + ey * ey;
+  }
+}
+
+static size_t
+simplify_list(WaypointList* list, double tolerance, SimplifyBuffers& buf)
+{
+  const size_t n = list->getWaypoints().size();
+  if (n < 3) {
+    return 0;
+  }
+
+  simplify_project(list, buf);
+  buf.dist.resize(n);
+  buf.keep.assign(n, false);
+  buf.keep[0] = true;
+  buf.keep[n - 1] = true;
+
+  // Iterative instead of recursive to be safe on very long tracks
+  const double tolerance2 = tolerance * tolerance;
+  buf.stack.clear();
+  for (size_t first = 0; first < n - 1; first += kMaxRunPoints) {
+    const size_t last = std::min(first + kMaxRunPoints, n - 1);
+    buf.keep[last] = true;
+    buf.stack.emplace_back(first, last);
+  }
+  while (!buf.stack.empty()) {
+    auto [first, last] = buf.stack.back();
+    buf.stack.pop_back();
+    if (last - first < 2) {
+      continue;
+    }
+    simplify_distances(buf, first, last);
+    size_t index = first;
+    double max = 0.0;
+    for (size_t i = first + 1; i < last; ++i) {
+      if (buf.dist[i] > max) {
+        max = buf.dist[i];
+        index = i;
+      }
+    }
+    if (max > tolerance2) {
+      buf.keep[index] = true;
+      buf.stack.emplace_back(first, index);
+      buf.stack.emplace_back(index, last);
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < n; ++i) {
+    kept += buf.keep[i] ? 1 : 0;
+  }
+  list->retainWaypoints(buf.keep);
+  return n - kept;
+}
+
+void
+simplify_geodata(Geodata* geodata, double tolerance)
+{
+  SimplifyBuffers buf;
+  size_t removed = 0;
+  for (auto&& route : geodata->getRoutes()) {
+    removed += simplify_list(&route, tolerance, buf);
+  }
+  for (auto&& track : geodata->getTracks()) {
+    removed += simplify_list(&track, tolerance, buf);
+  }
+  if (geodata->getDebugLevel() > 0) {
+    qDebug().nospace() << "simplify: removed " << removed << " points (tolerance " << tolerance << " m)";
+  }
+}
@@ -0,0 +1,32 @@
+/*
+
+    Track and route simplification (Douglas-Peucker)
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef SIMPLIFY_H_INCLUDED_
+#define SIMPLIFY_H_INCLUDED_
+
+#include "geodata.h"
+
+// Remove track and route points that deviate less than tolerance
+// meters from the simplified line. Start and end points are kept.
+void simplify_geodata(Geodata* geodata, double tolerance);
+
+#endif
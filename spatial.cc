@@ -0,0 +1,391 @@
+/*
+
+    Spatial index and bounding box selection
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+
+#include "spatial.h"
+
+// resolution of the Hilbert curve in bits per axis
+static constexpr int kHilbertBits = 16;
+
+static bool
+spatial_intersects(const GeoBox& a, const GeoBox& b)
+{
+  return a.minlat <= b.maxlat && a.maxlat >= b.minlat &&
+         a.minlon <= b.maxlon && a.maxlon >= b.minlon;
+}
+
+static void
+spatial_extend(GeoBox* a, const GeoBox& b)
+{
+  a->minlat = std::min(a->minlat, b.minlat);
+  a->minlon = std::min(a->minlon, b.minlon);
+  a->maxlat = std::max(a->maxlat, b.maxlat);
+  a->maxlon = std::max(a->maxlon, b.maxlon);
+}
+
+// Position of the cell x, y on the Hilbert curve filling the grid
+static quint64
+spatial_hilbert(quint32 x, quint32 y)
+{
+  const quint32 n = 1u << kHilbertBits;
+  quint64 d = 0;
+  for (quint32 s = n / 2; s > 0; s /= 2) {
+    const quint32 rx = (x & s) ? 1 : 0;
+    const quint32 ry = (y & s) ? 1 : 0;
+    d += static_cast<quint64>(s) * s * ((3 * rx) ^ ry);
+    if (ry == 0) {
+      if (rx == 1) {
+        x = n - 1 - x;
+        y = n - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+static quint32
+spatial_cell(double value, double min, double scale)
+{
+  const double cell = (value - min) * scale;
+  const double max = (1u << kHilbertBits) - 1;
+  return static_cast<quint32>(std::clamp(cell, 0.0, max));
+}
+
+/**********************************************************************/
+
+SpatialIndex::SpatialIndex(const Geodata& geodata)
+{
+  const auto& waypoints = geodata.getWaypoints();
+  for (size_t i = 0; i < waypoints.size(); ++i) {
+    add({SpatialRef::kWaypoint, static_cast<quint32>(i), 0}, waypoints[i], waypoints[i]);
+  }
+  auto add_lists = [this](SpatialRef::Kind kind, const std::deque<WaypointList>& lists) {
+    for (size_t i = 0; i < lists.size(); ++i) {
+      const auto& points = lists[i].getWaypoints();
+      const auto object = static_cast<quint32>(i);
+      if (points.size() == 1) {
+        add({kind, object, 0}, points.front(), points.front());
+      }
+      for (size_t j = 1; j < points.size(); ++j) {
+        add({kind, object, static_cast<quint32>(j - 1)}, points[j - 1], points[j]);
+      }
+    }
+  };
+  add_lists(SpatialRef::kRoute, geodata.getRoutes());
+  add_lists(SpatialRef::kTrack, geodata.getTracks());
+  build();
+}
+
+void
+SpatialIndex::add(const SpatialRef& ref, const Waypoint& a, const Waypoint& b)
+{
+  // points without coordinates are never inside a box
+  if (std::isnan(a.latitude) || std::isnan(a.longitude) ||
+      std::isnan(b.latitude) || std::isnan(b.longitude)) {
+    return;
+  }
+  boxes.push_back({std::min(a.latitude, b.latitude), std::min(a.longitude, b.longitude),
+                   std::max(a.latitude, b.latitude), std::max(a.longitude, b.longitude)});
+  refs.push_back(ref);
+}
+
+void
+SpatialIndex::build()
+{
+  const size_t count = boxes.size();
+  if (count == 0) {
+    return;
+  }
+
+  // map the centers to the Hilbert grid and sort the entries along
+  // the curve, neighbours on the curve are close on the map
+  GeoBox extent = boxes.front();
+  for (auto&& box : std::as_const(boxes)) {
+    spatial_extend(&extent, box);
+  }
+  const double max = (1u << kHilbertBits) - 1;
+  const double height = extent.maxlat - extent.minlat;
+  const double width = extent.maxlon - extent.minlon;
+  const double scale_lat = height > 0.0 ? max / height : 0.0;
+  const double scale_lon = width > 0.0 ? max / width : 0.0;
+
+  std::vector<std::pair<quint64, quint32>> order(count);
+  for (size_t i = 0; i < count; ++i) {
+    const GeoBox& box = boxes[i];
+    const quint32 x = spatial_cell((box.minlon + box.maxlon) / 2, extent.minlon, scale_lon);
+    const quint32 y = spatial_cell((box.minlat + box.maxlat) / 2, extent.minlat, scale_lat);
+    order[i] = {spatial_hilbert(x, y), static_cast<quint32>(i)};
+  }
+  std::sort(order.begin(), order.end());
+
+  std::vector<GeoBox> sorted_boxes;
+  std::vector<SpatialRef> sorted_refs;
+  sorted_boxes.reserve(count + count / (kNodeSize - 1) + 1);
+  sorted_refs.reserve(count);
+  for (auto&& entry : std::as_const(order)) {
+    sorted_boxes.push_back(boxes[entry.second]);
+    sorted_refs.push_back(refs[entry.second]);
+  }
+  boxes = std::move(sorted_boxes);
+  refs = std::move(sorted_refs);
+
+  // pack the levels bottom up until a single root is left
+  level_end.push_back(count);
+  size_t begin = 0;
+  size_t end = count;
+  while (end - begin > 1) {
+    for (size_t i = begin; i < end; i += kNodeSize) {
+      GeoBox node = boxes[i];
+      const size_t last = std::min(i + kNodeSize, end);
+      for (size_t j = i + 1; j < last; ++j) {
+        spatial_extend(&node, boxes[j]);
+      }
+      boxes.push_back(node);
+    }
+    begin = end;
+    end = boxes.size();
+    level_end.push_back(end);
+  }
+}
+
+void
+SpatialIndex::query(const GeoBox& box, std::vector<SpatialRef>* result) const
+{
+  if (level_end.empty()) {
+    return;
+  }
+  // node position and level, the leaves are level 0
+  std::vector<std::pair<size_t, size_t>> stack;
+  stack.emplace_back(boxes.size() - 1, level_end.size() - 1);
+  while (!stack.empty()) {
+    auto [pos, level] = stack.back();
+    stack.pop_back();
+    if (!spatial_intersects(boxes[pos], box)) {
+      continue;
+    }
+    if (level == 0) {
+      result->push_back(refs[pos]);
+      continue;
+    }
+    const size_t level_begin = level > 1 ? level_end[level - 2] : 0;
+    const size_t first = level_begin + (pos - level_end[level - 1]) * kNodeSize;
+    const size_t last = std::min(first + kNodeSize, level_end[level - 1]);
+    for (size_t child = first; child < last; ++child) {
+      stack.emplace_back(child, level - 1);
+    }
+  }
+}
+
+size_t
+SpatialIndex::size() const
+{
+  return refs.size();
+}
+
+/**********************************************************************/
+
+// Clip the segment a-b to the box (Liang-Barsky). On success the part
+// inside is a + t * (b - a) for t in t0 .. t1.
+static bool
+spatial_clip_segment(const GeoBox& box, const Waypoint& a, const Waypoint& b, double* t0, double* t1)
+{
+  const double dx = b.longitude - a.longitude;
+  const double dy = b.latitude - a.latitude;
+  const double p[4] = {-dx, dx, -dy, dy};
+  const double q[4] = {a.longitude - box.minlon, box.maxlon - a.longitude,
+                       a.latitude - box.minlat, box.maxlat - a.latitude
+                      };
+  double u0 = 0.0;
+  double u1 = 1.0;
+  for (int k = 0; k < 4; ++k) {
+    if (p[k] == 0.0) {
+      // parallel to this edge
+      if (q[k] < 0.0) {
+        return false;
+      }
+    } else {
+      const double r = q[k] / p[k];
+      if (p[k] < 0.0) {
+        if (r > u1) {
+          return false;
+        }
+        u0 = std::max(u0, r);
+      } else {
+        if (r < u0) {
+          return false;
+        }
+        u1 = std::min(u1, r);
+      }
+    }
+  }
+  *t0 = u0;
+  *t1 = u1;
+  return true;
+}
+
+static Waypoint
+spatial_interpolate(const Waypoint& a, const Waypoint& b, double t)
+{
+  Waypoint waypoint(a.latitude + t * (b.latitude - a.latitude),
+                    a.longitude + t * (b.longitude - a.longitude));
+  if (!std::isnan(a.elevation) && !std::isnan(b.elevation)) {
+    waypoint.elevation = a.elevation + t * (b.elevation - a.elevation);
+  }
+  return waypoint;
+}
+
+// Whether one of the candidate segments of list really crosses the
+// box, the index only compares bounding boxes
+static bool
+spatial_crosses(const WaypointList& list, const std::vector<quint32>& segments, const GeoBox& box)
+{
+  const auto& points = list.getWaypoints();
+  for (quint32 i : segments) {
+    double t0;
+    double t1;
+    if (points.size() == 1 || spatial_clip_segment(box, points[i], points[i + 1], &t0, &t1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Append the parts of list inside the box to pieces. The segments
+// are the sorted candidates from the index.
+static void
+spatial_clip_list(const WaypointList& list, const std::vector<quint32>& segments, const GeoBox& box,
+                  std::deque<WaypointList>* pieces)
+{
+  const auto& points = list.getWaypoints();
+  if (points.size() == 1) {
+    if (!segments.empty()) {
+      pieces->push_back(list);
+    }
+    return;
+  }
+  WaypointList* piece = nullptr;
+  // the current piece ends at the start point of segment next
+  bool open = false;
+  quint32 next = 0;
+  for (quint32 i : segments) {
+    const Waypoint& a = points[i];
+    const Waypoint& b = points[i + 1];
+    double t0;
+    double t1;
+    if (!spatial_clip_segment(box, a, b, &t0, &t1)) {
+      continue;
+    }
+    if (!open || i != next || t0 > 0.0) {
+      piece = &pieces->emplace_back(list.name);
+      piece->addWaypoint(t0 > 0.0 ? spatial_interpolate(a, b, t0) : Waypoint(a));
+    }
+    piece->addWaypoint(t1 < 1.0 ? spatial_interpolate(a, b, t1) : Waypoint(b));
+    open = t1 >= 1.0;
+    next = i + 1;
+  }
+}
+
+template<typename T>
+static void
+spatial_retain(std::deque<T>* items, const std::vector<bool>& keep)
+{
+  size_t count = 0;
+  for (size_t index = 0; index < items->size(); ++index) {
+    if (keep[index]) {
+      if (count != index) {
+        (*items)[count] = std::move((*items)[index]);
+      }
+      count++;
+    }
+  }
+  items->resize(count);
+}
+
+void
+spatial_select_geodata(Geodata* geodata, const GeoBox& box, bool clip)
+{
+  auto& waypoints = geodata->getWaypoints();
+  auto& routes = geodata->getRoutes();
+  auto& tracks = geodata->getTracks();
+  const size_t before = waypoints.size() + routes.size() + tracks.size();
+
+  std::vector<SpatialRef> hits;
+  {
+    SpatialIndex index(*geodata);
+    index.query(box, &hits);
+  }
+
+  std::vector<bool> keep_waypoints(waypoints.size(), false);
+  std::vector<std::vector<quint32>> route_segments(routes.size());
+  std::vector<std::vector<quint32>> track_segments(tracks.size());
+  for (auto&& hit : std::as_const(hits)) {
+    switch (hit.kind) {
+    case SpatialRef::kWaypoint:
+      // the box of a waypoint is the point itself
+      keep_waypoints[hit.object] = true;
+      break;
+    case SpatialRef::kRoute:
+      route_segments[hit.object].push_back(hit.index);
+      break;
+    case SpatialRef::kTrack:
+      track_segments[hit.object].push_back(hit.index);
+      break;
+    }
+  }
+
+  spatial_retain(&waypoints, keep_waypoints);
+
+  // routes are made of named points and kept as a whole
+  std::vector<bool> keep_routes(routes.size(), false);
+  for (size_t i = 0; i < routes.size(); ++i) {
+    keep_routes[i] = spatial_crosses(routes[i], route_segments[i], box);
+  }
+  spatial_retain(&routes, keep_routes);
+
+  if (clip) {
+    std::deque<WaypointList> pieces;
+    for (size_t i = 0; i < tracks.size(); ++i) {
+      std::sort(track_segments[i].begin(), track_segments[i].end());
+      spatial_clip_list(tracks[i], track_segments[i], box, &pieces);
+    }
+    tracks.swap(pieces);
+  } else {
+    std::vector<bool> keep_tracks(tracks.size(), false);
+    for (size_t i = 0; i < tracks.size(); ++i) {
+      keep_tracks[i] = spatial_crosses(tracks[i], track_segments[i], box);
+    }
+    spatial_retain(&tracks, keep_tracks);
+  }
+
+  if (geodata->getDebugLevel() > 0) {
+    qDebug().nospace() << "bbox: " << hits.size() << " index hits, kept "
+                       << waypoints.size() + routes.size() + tracks.size()
+                       << " of " << before << " objects";
+  }
+}
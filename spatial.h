@@ -0,0 +1,82 @@
+/*
+
+    Spatial index and bounding box selection
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef SPATIAL_H_INCLUDED_
+#define SPATIAL_H_INCLUDED_
+
+#include <QtGlobal>
+
+#include <vector>
+
+#include "geodata.h"
+
+// Box in degrees, the edges belong to the box
+struct GeoBox {
+  double minlat;
+  double minlon;
+  double maxlat;
+  double maxlon;
+};
+
+// A waypoint or the segment from point index to index + 1 of a route
+// or track. Lists with a single point have the segment 0 with both
+// ends at that point.
+struct SpatialRef {
+  enum Kind : quint8 {kWaypoint, kRoute, kTrack};
+  Kind kind;
+  quint32 object;
+  quint32 index;
+};
+
+// Packed Hilbert R-tree over the waypoints and segments of a
+// Geodata. The entries are sorted by the Hilbert value of their
+// center and packed bottom up into nodes of kNodeSize entries, so
+// building is O(n log n) and a query only descends into nodes
+// overlapping the box. The index refers to positions in the Geodata,
+// which must not change while the index is used.
+class SpatialIndex
+{
+public:
+  explicit SpatialIndex(const Geodata& geodata);
+
+  // Append all entries whose bounding box intersects box
+  void query(const GeoBox& box, std::vector<SpatialRef>* result) const;
+  size_t size() const;
+
+  static constexpr size_t kNodeSize = 16;
+private:
+  void add(const SpatialRef& ref, const Waypoint& a, const Waypoint& b);
+  void build();
+
+  // leaf entries first, then each level of nodes up to the root
+  std::vector<GeoBox> boxes;
+  std::vector<SpatialRef> refs;
+  // end of each level in boxes
+  std::vector<size_t> level_end;
+};
+
+// Keep only waypoints inside box and routes and tracks crossing it.
+// With clip tracks are cut at the edges of the box, every part inside
+// becomes a track of its own.
+void spatial_select_geodata(Geodata* geodata, const GeoBox& box, bool clip);
+
+#endif
@@ -0,0 +1,93 @@
+/*
+
+    Bounded lock-free single producer single consumer queue
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef SPSCQUEUE_H_INCLUDED_
+#define SPSCQUEUE_H_INCLUDED_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Ring buffer for exactly one producer and one consumer thread. The
+// producer only writes tail, the consumer only writes head, so no
+// locks are needed. Waiting is done by the caller with backoff().
+template<typename T>
+class SpscQueue
+{
+public:
+  explicit SpscQueue(size_t capacity) : slots(capacity + 1), head(0), tail(0) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+  SpscQueue(SpscQueue&&) = delete;
+  SpscQueue& operator=(SpscQueue&&) = delete;
+
+  // producer side, value is only moved from on success
+  bool tryPush(T& value)
+  {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    const size_t next = t + 1 == slots.size() ? 0 : t + 1;
+    if (next == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots[t] = std::move(value);
+    tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side
+  bool tryPop(T& value)
+  {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = std::move(slots[h]);
+    head.store(h + 1 == slots.size() ? 0 : h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Wait for the other side: spin shortly, then yield, then sleep.
+  // spins counts the unsuccessful attempts and is reset by the
+  // caller after progress.
+  static void backoff(int& spins)
+  {
+    if (spins < 64) {
+      spins++;
+    } else if (spins < 128) {
+      spins++;
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+private:
+  std::vector<T> slots;
+  // separate cache lines to avoid false sharing between the threads
+  alignas(64) std::atomic<size_t> head;
+  alignas(64) std::atomic<size_t> tail;
+};
+
+#endif
@@ -0,0 +1,218 @@
+/*
+
+    Per phase conversion statistics
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <QDebug>
+#include <QSaveFile>
+#include <QString>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "stats.h"
+
+struct StatsEntry {
+  const char* phase;
+  QString format;
+  quint64 calls;
+  qint64 nsecs;
+  AllocCount allocs;
+  PerfCount perf;
+};
+
+static std::atomic<bool> stats_enabled(false);
+static std::atomic<bool> stats_perf_enabled(false);
+static std::mutex stats_mutex;
+static std::vector<StatsEntry> stats_entries;
+
+/**********************************************************************/
+
+void
+Stats::enable()
+{
+  stats_enabled = true;
+}
+
+bool
+Stats::isEnabled()
+{
+  return stats_enabled;
+}
+
+void
+Stats::enablePerfCounters()
+{
+  stats_perf_enabled = true;
+}
+
+bool
+Stats::isPerfCountersEnabled()
+{
+  return stats_perf_enabled;
+}
+
+void
+Stats::record(const char* phase, const QString& format, qint64 nsecs, const AllocCount& allocs, const PerfCount* perf)
+{
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  StatsEntry* entry = nullptr;
+  for (auto&& e : stats_entries) {
+    if (qstrcmp(e.phase, phase) == 0 && e.format == format) {
+      entry = &e;
+      break;
+    }
+  }
+  if (!entry) {
+    StatsEntry e{phase, format, 0, 0, {0, 0}, {}};
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+      e.perf.valid[i] = perf != nullptr;
+      e.perf.value[i] = 0;
+    }
+    stats_entries.push_back(e);
+    entry = &stats_entries.back();
+  }
+  entry->calls++;
+  entry->nsecs += nsecs;
+  entry->allocs.count += allocs.count;
+  entry->allocs.bytes += allocs.bytes;
+  for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+    // a counter is only reported if it was valid for every call
+    entry->perf.valid[i] = entry->perf.valid[i] && perf && perf->valid[i];
+    entry->perf.value[i] += perf ? perf->value[i] : 0;
+  }
+}
+
+static QString
+stats_perf_value(const PerfCount& perf, int counter)
+{
+  return perf.valid[counter] ? QString::number(perf.value[counter]) : QStringLiteral("-");
+}
+
+void
+Stats::report()
+{
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  bool allocs = AllocStats::isAvailable();
+  bool perf = stats_perf_enabled;
+
+  QString header = QStringLiteral("%1 %2 %3 %4 %5 %6")
+                   .arg("phase", -8)
+                   .arg("format", -10)
+                   .arg("calls", 6)
+                   .arg("time[ms]", 10)
+                   .arg("allocs", 10)
+                   .arg("bytes", 12);
+  if (perf) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+      header += QStringLiteral(" %1").arg(QString::fromLatin1(PerfCounters::getName(i)), 14);
+    }
+    header += QStringLiteral(" %1").arg("IPC", 6);
+  }
+  qInfo().noquote() << header;
+
+  bool perf_available = false;
+  for (auto&& entry : std::as_const(stats_entries)) {
+    QString line = QStringLiteral("%1 %2 %3 %4 %5 %6")
+                   .arg(QString::fromLatin1(entry.phase), -8)
+                   .arg(entry.format.isEmpty() ? QStringLiteral("-") : entry.format, -10)
+                   .arg(entry.calls, 6)
+                   .arg(entry.nsecs / 1e6, 10, 'f', 3)
+                   .arg(allocs ? QString::number(entry.allocs.count) : QStringLiteral("-"), 10)
+                   .arg(allocs ? QString::number(entry.allocs.bytes) : QStringLiteral("-"), 12);
+    if (perf) {
+      for (int i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        line += QStringLiteral(" %1").arg(stats_perf_value(entry.perf, i), 14);
+        perf_available = perf_available || entry.perf.valid[i];
+      }
+      const quint64 cycles = entry.perf.value[PERF_CYCLES];
+      if (entry.perf.valid[PERF_CYCLES] && entry.perf.valid[PERF_INSTRUCTIONS] && cycles > 0) {
+        line += QStringLiteral(" %1").arg(static_cast<double>(entry.perf.value[PERF_INSTRUCTIONS]) / cycles, 6, 'f', 2);
+      } else {
+        line += QStringLiteral(" %1").arg("-", 6);
+      }
+    }
+    qInfo().noquote() << line;
+  }
+
+  if (perf && !perf_available && !stats_entries.empty()) {
+    qInfo().noquote() << "note: hardware performance counters not available";
+  }
+}
+
+// Machine readable variant of the report used by the performance
+// regression tests: one "<phase>.<format>.<key> <value>" per line
+// with integer values. Rates are calls per second, allocations and
+// bytes are per call to be independent of --repeat.
+bool
+Stats::writeFile(const QString& filename)
+{
+  std::lock_guard<std::mutex> lock(stats_mutex);
+
+  QByteArray data("# ggvtogpx stats\n");
+  for (auto&& entry : std::as_const(stats_entries)) {
+    QByteArray prefix(entry.phase);
+    if (! entry.format.isEmpty()) {
+      prefix += '.' + entry.format.toUtf8();
+    }
+    qint64 rate = entry.nsecs > 0 ? static_cast<qint64>(entry.calls * 1e9 / entry.nsecs) : 0;
+    data += prefix + ".calls " + QByteArray::number(entry.calls) + '\n';
+    data += prefix + ".rate " + QByteArray::number(rate) + '\n';
+    if (AllocStats::isAvailable()) {
+      data += prefix + ".allocs " + QByteArray::number(entry.allocs.count / entry.calls) + '\n';
+      data += prefix + ".bytes " + QByteArray::number(entry.allocs.bytes / entry.calls) + '\n';
+    }
+  }
+
+  QSaveFile file(filename);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  file.write(data);
+  return file.commit();
+}
+
+/**********************************************************************/
+
+PhaseScope::PhaseScope(const char* _phase, const QString& _format) :
+  span("phase", _phase, _format), phase(_phase), enabled(Stats::isEnabled())
+{
+  if (enabled) {
+    format = _format;
+    if (Stats::isPerfCountersEnabled()) {
+      perf.emplace();
+    }
+    timer.start();
+  }
+}
+
+PhaseScope::~PhaseScope()
+{
+  if (enabled) {
+    qint64 nsecs = timer.nsecsElapsed();
+    if (perf) {
+      PerfCount count = perf->stop();
+      Stats::record(phase, format, nsecs, allocs.delta(), &count);
+    } else {
+      Stats::record(phase, format, nsecs, allocs.delta(), nullptr);
+    }
+  }
+}
@@ -0,0 +1,72 @@
+/*
+
+    Per phase conversion statistics
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef STATS_H_INCLUDED_
+#define STATS_H_INCLUDED_
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <optional>
+
+#include "allocstats.h"
+#include "perfcounters.h"
+#include "trace.h"
+
+// Accumulates wall clock time, allocation counts and optionally
+// hardware performance counters per phase (probe, read, write) and
+// format. Recording is off by default.
+class Stats
+{
+public:
+  static void enable();
+  static bool isEnabled();
+  static void enablePerfCounters();
+  static bool isPerfCountersEnabled();
+  static void record(const char* phase, const QString& format, qint64 nsecs, const AllocCount& allocs, const PerfCount* perf);
+  static void report();
+  static bool writeFile(const QString& filename);
+};
+
+// Measures one phase and reports it to Stats and Trace
+class PhaseScope
+{
+public:
+  PhaseScope(const char* _phase, const QString& _format = QString());
+  ~PhaseScope();
+
+  PhaseScope(const PhaseScope&) = delete;
+  PhaseScope& operator=(const PhaseScope&) = delete;
+  PhaseScope(PhaseScope&&) = delete;
+  PhaseScope& operator=(PhaseScope&&) = delete;
+private:
+  TraceSpan span;
+  const char* phase;
+  QString format;
+  QElapsedTimer timer;
+  AllocCounter allocs;
+  // in place so that it does not show up in the allocation count
+  std::optional<PerfCounters> perf;
+  bool enabled;
+};
+
+#endif
@@ -0,0 +1,197 @@
+/*
+
+    Joining of track fragments with touching ends
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "geogrid.h"
+#include "stitch.h"
+
+// A track in a chain, reversed if it is walked from end to start
+struct StitchPiece {
+  size_t track;
+  bool reversed;
+};
+
+// Both ends of every free track are in the grid. The id of the start
+// of track i is 2 * i, the id of its end 2 * i + 1.
+static const Waypoint&
+stitch_endpoint(const std::deque<WaypointList>& tracks, size_t id)
+{
+  const auto& points = tracks[id / 2].getWaypoints();
+  return id % 2 == 0 ? points.front() : points.back();
+}
+
+static bool
+stitch_finite(const Waypoint& point)
+{
+  return std::isfinite(point.latitude) && std::isfinite(point.longitude);
+}
+
+// tracks without points or with an undefined end are not joined
+static bool
+stitch_joinable(const WaypointList& track)
+{
+  const auto& points = track.getWaypoints();
+  return !points.empty() && stitch_finite(points.front()) && stitch_finite(points.back());
+}
+
+// Mark a track as used and drop its ends from the grid, so the cells
+// of a junction shrink as its tracks are joined
+static void
+stitch_take(GeoGrid* grid, const std::deque<WaypointList>& tracks, std::vector<bool>* used, size_t track)
+{
+  (*used)[track] = true;
+  if (stitch_joinable(tracks[track])) {
+    grid->remove(stitch_endpoint(tracks, 2 * track), 2 * track);
+    grid->remove(stitch_endpoint(tracks, 2 * track + 1), 2 * track + 1);
+  }
+}
+
+// The shared point is written once when both fragments contain it
+static bool
+stitch_same_point(const Waypoint& a, const Waypoint& b)
+{
+  return a.latitude == b.latitude && a.longitude == b.longitude &&
+         (a.elevation == b.elevation || (std::isnan(a.elevation) && std::isnan(b.elevation)));
+}
+
+// Id of the closest end of a free track within tolerance of point,
+// the lowest id if several are equally close, or SIZE_MAX
+static size_t
+stitch_closest(const GeoGrid& grid, const std::deque<WaypointList>& tracks,
+               const Waypoint& point, double tolerance, std::vector<size_t>* candidates)
+{
+  candidates->clear();
+  grid.query(point, candidates);
+  size_t best = SIZE_MAX;
+  double best_distance = 0.0;
+  for (size_t id : *candidates) {
+    const double distance = GeoGrid::distance(point, stitch_endpoint(tracks, id));
+    if (distance > tolerance) {
+      continue;
+    }
+    if (best == SIZE_MAX || distance < best_distance || (distance == best_distance && id < best)) {
+      best = id;
+      best_distance = distance;
+    }
+  }
+  return best;
+}
+
+static void
+stitch_append(WaypointList* target, WaypointList* piece, bool reversed)
+{
+  auto& points = piece->getWaypoints();
+  const size_t n = points.size();
+  for (size_t i = 0; i < n; ++i) {
+    Waypoint& point = points[reversed ? n - 1 - i : i];
+    const auto& joined = target->getWaypoints();
+    if (i == 0 && !joined.empty() && stitch_same_point(joined.back(), point)) {
+      continue;
+    }
+    target->addWaypoint(std::move(point));
+  }
+}
+
+size_t
+stitch_geodata(Geodata* geodata, double tolerance)
+{
+  auto& tracks = geodata->getTracks();
+  const size_t count = tracks.size();
+
+  GeoGrid grid(tolerance);
+  for (size_t i = 0; i < count; ++i) {
+    if (stitch_joinable(tracks[i])) {
+      grid.insert(stitch_endpoint(tracks, 2 * i), 2 * i);
+      grid.insert(stitch_endpoint(tracks, 2 * i + 1), 2 * i + 1);
+    }
+  }
+
+  std::deque<WaypointList> result;
+  std::vector<bool> used(count, false);
+  std::vector<size_t> candidates;
+  std::deque<StitchPiece> chain;
+  size_t joined = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (used[i]) {
+      continue;
+    }
+    stitch_take(&grid, tracks, &used, i);
+    if (!stitch_joinable(tracks[i])) {
+      result.push_back(std::move(tracks[i]));
+      continue;
+    }
+    const auto& points = tracks[i].getWaypoints();
+
+    // Extend the chain at its end, then at its start. The open ends
+    // point into the tracks, which are not moved before the chain is
+    // complete.
+    chain.clear();
+    chain.push_back({i, false});
+    const Waypoint* tail = &points.back();
+    for (;;) {
+      const size_t id = stitch_closest(grid, tracks, *tail, tolerance, &candidates);
+      if (id == SIZE_MAX) {
+        break;
+      }
+      const bool reversed = id % 2 == 1;
+      stitch_take(&grid, tracks, &used, id / 2);
+      chain.push_back({id / 2, reversed});
+      tail = &stitch_endpoint(tracks, reversed ? id - 1 : id + 1);
+    }
+    const Waypoint* head = &points.front();
+    for (;;) {
+      const size_t id = stitch_closest(grid, tracks, *head, tolerance, &candidates);
+      if (id == SIZE_MAX) {
+        break;
+      }
+      const bool reversed = id % 2 == 0;
+      stitch_take(&grid, tracks, &used, id / 2);
+      chain.push_front({id / 2, reversed});
+      head = &stitch_endpoint(tracks, reversed ? id + 1 : id - 1);
+    }
+
+    if (chain.size() == 1) {
+      result.push_back(std::move(tracks[i]));
+      continue;
+    }
+    size_t total = 0;
+    for (const auto& piece : chain) {
+      total += tracks[piece.track].getWaypoints().size();
+    }
+    WaypointList track(tracks[i].name);
+    track.reserve(total);
+    for (const auto& piece : chain) {
+      stitch_append(&track, &tracks[piece.track], piece.reversed);
+    }
+    result.push_back(std::move(track));
+    joined += chain.size() - 1;
+  }
+
+  tracks.swap(result);
+  return joined;
+}
@@ -0,0 +1,37 @@
+/*
+
+    Joining of track fragments with touching ends
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+
+#ifndef STITCH_H_INCLUDED_
+#define STITCH_H_INCLUDED_
+
+#include "geodata.h"
+
+// Join tracks whose end points are at most tolerance meters apart
+// into longer tracks. Starting with the first track, a track is
+// extended at both ends with the closest free fragment, which is
+// reversed if needed. A joined track keeps the name of its first
+// fragment and its position. Returns the number of tracks joined to
+// another.
+size_t stitch_geodata(Geodata* geodata, double tolerance);
+
+#endif
@@ -0,0 +1,330 @@
+/*
+
+    Length, extent and elevation summary of routes and tracks
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <QByteArray>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "jsonwrite.h"
+#include "parallel.h"
+#include "summary.h"
+
+static const double kEarthRadius = 6371000.0;
+// summarize on one thread below this number of points
+static const size_t kParallelMinPoints = 65536;
+// half chord length up to which the series for asin is exact to the
+// last bit, about 127 km on the ground
+static const double kSeriesLimit = 0.01;
+// write the buffer to the device when it gets larger than this
+static const qsizetype kFlushSize = 64 * 1024;
+
+// Scratch buffers of one thread, reused for all lists
+struct SummaryBuffers {
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> z;
+  std::vector<double> ele;
+  std::vector<double> half_chord;
+};
+
+// Unit vectors of the points. The trigonometric functions are
+// evaluated once per point, the segment loops below only need
+// arithmetic.
+static void
+summary_project(const std::vector<Waypoint>& points, SummaryBuffers& buf)
+{
+  const size_t n = points.size();
+  buf.x.resize(n);
+  buf.y.resize(n);
+  buf.z.resize(n);
+  buf.ele.resize(n);
+  const double deg = M_PI / 180.0;
+  for (size_t i = 0; i < n; ++i) {
+    const double lat = points[i].latitude * deg;
+    const double lon = points[i].longitude * deg;
+    const double c = std::cos(lat);
+    buf.x[i] = c * std::cos(lon);
+    buf.y[i] = c * std::sin(lon);
+    buf.z[i] = std::sin(lat);
+    buf.ele[i] = points[i].elevation;
+  }
+}
+
+// Great circle length of the line. The central angle of a segment is
+// 2 asin(h) with h half the chord between the unit vectors, the same
+// as the haversine formula. asin is replaced by its series, which is
+// exact for segments shorter than kSeriesLimit, and longer segments
+// are corrected afterwards. The sums use four lanes.
+static double
+summary_length(SummaryBuffers& buf)
+{
+  const size_t n = buf.x.size();
+  if (n < 2) {
+    return 0.0;
+  }
+  const size_t m = n - 1;
+  const double* x = buf.x.data();
+  const double* y = buf.y.data();
+  const double* z = buf.z.data();
+  buf.half_chord.resize(m);
+  double* h = buf.half_chord.data();
+  for (size_t i = 0; i < m; ++i) {
+    const double dx = x[i + 1] - x[i];
+    const double dy = y[i + 1] - y[i];
+    const double dz = z[i + 1] - z[i];
+    h[i] = 0.5 * std::sqrt(dx * dx + dy * dy + dz * dz);
+  }
+
+  double sum[4] = {0.0, 0.0, 0.0, 0.0};
+  double max[4] = {0.0, 0.0, 0.0, 0.0};
+  size_t i = 0;
+  for (; i + 4 <= m; i += 4) {
+    for (size_t k = 0; k < 4; ++k) {
+      const double v = h[i + k];
+      const double v2 = v * v;
+      sum[k] += v * (1.0 + v2 * (1.0 / 6.0 + v2 * (3.0 / 40.0 + v2 * (5.0 / 112.0))));
+      max[k] = v > max[k] ? v : max[k];
+    }
+  }
+  for (; i < m; ++i) {
+    const double v = h[i];
+    const double v2 = v * v;
+    sum[0] += v * (1.0 + v2 * (1.0 / 6.0 + v2 * (3.0 / 40.0 + v2 * (5.0 / 112.0))));
+    max[0] = v > max[0] ? v : max[0];
+  }
+  double total = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+
+  if (std::max(std::max(max[0], max[1]), std::max(max[2], max[3])) > kSeriesLimit) {
+    for (size_t j = 0; j < m; ++j) {
+      const double v = h[j];
+      if (v > kSeriesLimit) {
+        const double v2 = v * v;
+        total += std::asin(std::min(v, 1.0)) - v * (1.0 + v2 * (1.0 / 6.0 + v2 * (3.0 / 40.0 + v2 * (5.0 / 112.0))));
+      }
+    }
+  }
+  return 2.0 * kEarthRadius * total;
+}
+
+// Sum of the rises and falls between neighbouring points that both
+// have an elevation. Comparisons with NaN are false, so points
+// without elevation contribute nothing.
+static void
+summary_elevation(const SummaryBuffers& buf, double* gain, double* loss)
+{
+  const size_t n = buf.ele.size();
+  const double* e = buf.ele.data();
+  double up[4] = {0.0, 0.0, 0.0, 0.0};
+  double down[4] = {0.0, 0.0, 0.0, 0.0};
+  const size_t m = n > 0 ? n - 1 : 0;
+  size_t i = 0;
+  for (; i + 4 <= m; i += 4) {
+    for (size_t k = 0; k < 4; ++k) {
+      const double d = e[i + k + 1] - e[i + k];
+      up[k] += d > 0.0 ? d : 0.0;
+      down[k] += d < 0.0 ? -d : 0.0;
+    }
+  }
+  for (; i < m; ++i) {
+    const double d = e[i + 1] - e[i];
+    up[0] += d > 0.0 ? d : 0.0;
+    down[0] += d < 0.0 ? -d : 0.0;
+  }
+  *gain = (up[0] + up[1]) + (up[2] + up[3]);
+  *loss = (down[0] + down[1]) + (down[2] + down[3]);
+}
+
+static SummaryRecord
+summary_list(const WaypointList& list, bool route, SummaryBuffers& buf)
+{
+  const auto& points = list.getWaypoints();
+  SummaryRecord record;
+  record.route = route;
+  record.name = &list.name;
+  record.points = points.size();
+  record.minlat = NAN;
+  record.minlon = NAN;
+  record.maxlat = NAN;
+  record.maxlon = NAN;
+  record.has_elevation = false;
+  record.gain = NAN;
+  record.loss = NAN;
+  if (points.empty()) {
+    record.length = 0.0;
+    return record;
+  }
+
+  record.minlat = record.maxlat = points.front().latitude;
+  record.minlon = record.maxlon = points.front().longitude;
+  for (const auto& point : points) {
+    record.minlat = std::min(record.minlat, point.latitude);
+    record.maxlat = std::max(record.maxlat, point.latitude);
+    record.minlon = std::min(record.minlon, point.longitude);
+    record.maxlon = std::max(record.maxlon, point.longitude);
+    record.has_elevation = record.has_elevation || !std::isnan(point.elevation);
+  }
+
+  summary_project(points, buf);
+  record.length = summary_length(buf);
+  if (record.has_elevation) {
+    summary_elevation(buf, &record.gain, &record.loss);
+  }
+  return record;
+}
+
+// RFC 4180 field, quoted if it contains a separator, quote or line break
+static void
+summary_append_csv_string(QByteArray& out, const QString& str)
+{
+  QByteArray utf8 = str.toUtf8();
+  if (utf8.contains(',') || utf8.contains('"') || utf8.contains('\n') || utf8.contains('\r')) {
+    out += '"';
+    out += utf8.replace("\"", "\"\"");
+    out += '"';
+  } else {
+    out += utf8;
+  }
+}
+
+void
+SummaryFormat::write(QIODevice* io, const Geodata* geodata)
+{
+  std::vector<std::pair<const WaypointList*, bool>> lists;
+  lists.reserve(geodata->getRoutes().size() + geodata->getTracks().size());
+  size_t points = 0;
+  for (const auto& route : geodata->getRoutes()) {
+    lists.emplace_back(&route, true);
+    points += route.getWaypoints().size();
+  }
+  for (const auto& track : geodata->getTracks()) {
+    lists.emplace_back(&track, false);
+    points += track.getWaypoints().size();
+  }
+
+  std::vector<SummaryRecord> records(lists.size());
+  // automatic: one thread for small files
+  const int nthreads = threads > 0 ? threads : (points < kParallelMinPoints ? 1 : 0);
+  std::vector<SummaryBuffers> buffers(parallel_threads(nthreads, lists.size()));
+  parallel_for(lists.size(), nthreads, [&](size_t i, int worker) {
+    records[i] = summary_list(*lists[i].first, lists[i].second, buffers[worker]);
+  });
+
+  if (csv) {
+    writeCsv(io, records);
+  } else {
+    writeJson(io, records);
+  }
+}
+
+void
+SummaryFormat::writeJson(QIODevice* io, const std::vector<SummaryRecord>& records)
+{
+  QByteArray buffer;
+  buffer.reserve(kFlushSize + 4096);
+  buffer += "{\"objects\":[\n";
+  bool first = true;
+  for (const auto& record : records) {
+    if (!first) {
+      buffer += ",\n";
+    }
+    first = false;
+    buffer += record.route ? "{\"type\":\"route\",\"name\":" : "{\"type\":\"track\",\"name\":";
+    jsonwrite_string(buffer, *record.name);
+    buffer += ",\"points\":";
+    buffer += QByteArray::number(quint64(record.points));
+    buffer += ",\"length\":";
+    jsonwrite_value(buffer, record.length, kMeterDigits);
+    buffer += ",\"mean_segment\":";
+    jsonwrite_value(buffer, record.points > 1 ? record.length / (record.points - 1) : NAN, kMeterDigits);
+    buffer += ",\"minlat\":";
+    jsonwrite_value(buffer, record.minlat, coord_digits);
+    buffer += ",\"minlon\":";
+    jsonwrite_value(buffer, record.minlon, coord_digits);
+    buffer += ",\"maxlat\":";
+    jsonwrite_value(buffer, record.maxlat, coord_digits);
+    buffer += ",\"maxlon\":";
+    jsonwrite_value(buffer, record.maxlon, coord_digits);
+    buffer += ",\"gain\":";
+    jsonwrite_value(buffer, record.gain, kMeterDigits);
+    buffer += ",\"loss\":";
+    jsonwrite_value(buffer, record.loss, kMeterDigits);
+    buffer += '}';
+    if (buffer.size() >= kFlushSize) {
+      io->write(buffer);
+      buffer.resize(0);
+    }
+  }
+  buffer += "\n]}\n";
+  io->write(buffer);
+}
+
+void
+SummaryFormat::writeCsv(QIODevice* io, const std::vector<SummaryRecord>& records)
+{
+  QByteArray buffer;
+  buffer.reserve(kFlushSize + 4096);
+  buffer += "type,name,points,length,mean_segment,minlat,minlon,maxlat,maxlon,gain,loss\n";
+  // empty fields for undefined and infinite values
+  auto field = [&buffer](double value, int digits) {
+    buffer += ',';
+    if (std::isfinite(value)) {
+      jsonwrite_number(buffer, value, digits);
+    }
+  };
+  for (const auto& record : records) {
+    buffer += record.route ? "route," : "track,";
+    summary_append_csv_string(buffer, *record.name);
+    buffer += ',';
+    buffer += QByteArray::number(quint64(record.points));
+    field(record.length, kMeterDigits);
+    field(record.points > 1 ? record.length / (record.points - 1) : NAN, kMeterDigits);
+    field(record.minlat, coord_digits);
+    field(record.minlon, coord_digits);
+    field(record.maxlat, coord_digits);
+    field(record.maxlon, coord_digits);
+    field(record.gain, kMeterDigits);
+    field(record.loss, kMeterDigits);
+    buffer += '\n';
+    if (buffer.size() >= kFlushSize) {
+      io->write(buffer);
+      buffer.resize(0);
+    }
+  }
+  io->write(buffer);
+}
+
+void SummaryFormat::setCoordinatePrecision(int digits)
+{
+  coord_digits = digits;
+}
+
+void SummaryFormat::setThreads(int _threads)
+{
+  threads = _threads;
+}
+
+const QString SummaryFormat::getName()
+{
+  return csv ? "summary-csv" : "summary";
+}
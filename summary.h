@@ -0,0 +1,80 @@
+/*
+
+    Length, extent and elevation summary of routes and tracks
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+#ifndef SUMMARY_H_INCLUDED_
+#define SUMMARY_H_INCLUDED_
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+#include <vector>
+
+#include "format.h"
+#include "geodata.h"
+
+// Statistics of one route or track. Lengths are in meters on a
+// sphere, gain and loss are NaN without elevations and the bounds
+// are NaN for an empty list.
+struct SummaryRecord {
+  bool route;
+  const QString* name;
+  size_t points;
+  double length;
+  double minlat;
+  double minlon;
+  double maxlat;
+  double maxlon;
+  bool has_elevation;
+  double gain;
+  double loss;
+};
+
+// Writes one line per route and track with its number of points,
+// length, mean segment length, bounds and elevation gain and loss,
+// as JSON or CSV. The coordinates of each list are converted to
+// contiguous arrays first, so the loops over the segments have no
+// branches and can be vectorized. Lists are summarized on several
+// threads for large files.
+class SummaryFormat : public Format
+{
+public:
+  explicit SummaryFormat(bool _csv) : csv(_csv), coord_digits(kDefaultDigits), threads(0) {};
+
+  void write(QIODevice* io, const Geodata* geodata) override;
+  void setCoordinatePrecision(int digits);
+  // number of threads, 0 is automatic
+  void setThreads(int _threads);
+  virtual const QString getName() override;
+
+  static const int kDefaultDigits = 9;
+  // lengths, gain and loss are written in millimeters precision
+  static const int kMeterDigits = 3;
+private:
+  void writeJson(QIODevice* io, const std::vector<SummaryRecord>& records);
+  void writeCsv(QIODevice* io, const std::vector<SummaryRecord>& records);
+
+  bool csv;
+  int coord_digits;
+  int threads;
+};
+
+#endif
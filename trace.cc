@@ -0,0 +1,160 @@
+/*
+
+    Trace Event Format (Chrome trace / Perfetto) recording
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "trace.h"
+
+struct TraceEvent {
+  const char* category;
+  const char* name;
+  QString detail;
+  qint64 start;
+  qint64 duration;
+  int tid;
+};
+
+static std::atomic<bool> trace_enabled(false);
+static std::mutex trace_mutex;
+static std::vector<TraceEvent> trace_events;
+
+static const std::chrono::steady_clock::time_point trace_epoch = std::chrono::steady_clock::now();
+
+// Small sequential thread ids are much easier to read in the trace
+// viewer than the values of std::thread::id
+static int
+trace_thread_id()
+{
+  static std::atomic<int> next_tid(1);
+  thread_local int tid = next_tid++;
+  return tid;
+}
+
+/**********************************************************************/
+
+void
+Trace::enable()
+{
+  // register the calling (main) thread first so it gets tid 1
+  trace_thread_id();
+  trace_enabled = true;
+}
+
+bool
+Trace::isEnabled()
+{
+  return trace_enabled;
+}
+
+qint64
+Trace::now()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - trace_epoch).count();
+}
+
+void
+Trace::addEvent(const char* category, const char* name, const QString& detail, qint64 start, qint64 duration)
+{
+  int tid = trace_thread_id();
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  trace_events.push_back({category, name, detail, start, duration, tid});
+}
+
+bool
+Trace::write(const QString& filename)
+{
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  qint64 pid = QCoreApplication::applicationPid();
+
+  QJsonArray events;
+  int max_tid = 0;
+  for (auto&& e : std::as_const(trace_events)) {
+    QJsonObject event;
+    event.insert(QStringLiteral("name"), QString::fromLatin1(e.name));
+    event.insert(QStringLiteral("cat"), QString::fromLatin1(e.category));
+    event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+    event.insert(QStringLiteral("ts"), e.start);
+    event.insert(QStringLiteral("dur"), e.duration);
+    event.insert(QStringLiteral("pid"), pid);
+    event.insert(QStringLiteral("tid"), e.tid);
+    if (! e.detail.isEmpty()) {
+      QJsonObject args;
+      args.insert(QStringLiteral("detail"), e.detail);
+      event.insert(QStringLiteral("args"), args);
+    }
+    events.append(event);
+    if (e.tid > max_tid) {
+      max_tid = e.tid;
+    }
+  }
+
+  // Metadata events to give the threads stable names in the viewer
+  for (int tid = 1; tid <= max_tid; ++tid) {
+    QJsonObject args;
+    args.insert(QStringLiteral("name"), tid == 1 ? QStringLiteral("main") : QStringLiteral("worker %1").arg(tid - 1));
+    QJsonObject event;
+    event.insert(QStringLiteral("name"), QStringLiteral("thread_name"));
+    event.insert(QStringLiteral("ph"), QStringLiteral("M"));
+    event.insert(QStringLiteral("pid"), pid);
+    event.insert(QStringLiteral("tid"), tid);
+    event.insert(QStringLiteral("args"), args);
+    events.append(event);
+  }
+
+  QJsonObject root;
+  root.insert(QStringLiteral("traceEvents"), events);
+  root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+  QFile file(filename);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  QByteArray data = QJsonDocument(root).toJson(QJsonDocument::Compact);
+  return file.write(data) == data.size();
+}
+
+/**********************************************************************/
+
+TraceSpan::TraceSpan(const char* _category, const char* _name, const QString& _detail) :
+  category(_category), name(_name), start(0), enabled(Trace::isEnabled())
+{
+  if (enabled) {
+    detail = _detail;
+    start = Trace::now();
+  }
+}
+
+TraceSpan::~TraceSpan()
+{
+  if (enabled) {
+    Trace::addEvent(category, name, detail, start, Trace::now() - start);
+  }
+}
@@ -0,0 +1,59 @@
+/*
+
+    Trace Event Format (Chrome trace / Perfetto) recording
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef TRACE_H_INCLUDED_
+#define TRACE_H_INCLUDED_
+
+#include <QString>
+
+// Collects complete ("ph":"X") events in memory and writes them as a
+// JSON file that can be loaded into chrome://tracing or Perfetto.
+// Recording is off by default and TraceSpan is a cheap no-op then.
+class Trace
+{
+public:
+  static void enable();
+  static bool isEnabled();
+  static qint64 now();
+  static void addEvent(const char* category, const char* name, const QString& detail, qint64 start, qint64 duration);
+  static bool write(const QString& filename);
+};
+
+class TraceSpan
+{
+public:
+  TraceSpan(const char* _category, const char* _name, const QString& _detail = QString());
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+  TraceSpan(TraceSpan&&) = delete;
+  TraceSpan& operator=(TraceSpan&&) = delete;
+private:
+  const char* category;
+  const char* name;
+  QString detail;
+  qint64 start;
+  bool enabled;
+};
+
+#endif
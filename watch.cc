@@ -0,0 +1,188 @@
+/*
+
+    Watch a directory and convert new overlay files
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFileInfo>
+
+#include "watch.h"
+
+// quiet time before a burst of events is converted
+static const int kDebounceMsecs = 250;
+
+DirectoryWatcher::DirectoryWatcher(const QString& _watch_dir, const QString& _out_dir, const QString& _suffix,
+                                   const QStringList& _arguments, int _jobs) :
+  watch_dir(_watch_dir), out_dir(_out_dir), suffix(_suffix), arguments(_arguments),
+  jobs(_jobs), active(0), debuglevel(0), fd(-1)
+{
+  debounce.setSingleShot(true);
+  debounce.setInterval(kDebounceMsecs);
+  QObject::connect(&debounce, &QTimer::timeout, [this]() {
+    schedule();
+  });
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+  notifier.reset();
+#ifdef __linux__
+  if (fd >= 0) {
+    close(fd);
+  }
+#endif
+}
+
+bool
+DirectoryWatcher::start()
+{
+#ifdef __linux__
+  fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  QByteArray path = QFile::encodeName(watch_dir.absolutePath());
+  if (inotify_add_watch(fd, path.constData(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    return false;
+  }
+  notifier = std::make_unique<QSocketNotifier>(fd, QSocketNotifier::Read);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+  // overloaded with the deprecated activated(int) in Qt 5.15
+  const auto activated = qOverload<QSocketDescriptor, QSocketNotifier::Type>(&QSocketNotifier::activated);
+#else
+  const auto activated = &QSocketNotifier::activated;
+#endif
+  QObject::connect(notifier.get(), activated, [this]() {
+    readEvents();
+  });
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+DirectoryWatcher::readEvents()
+{
+#ifdef __linux__
+  alignas(struct inotify_event) char buf[4096];
+  for (;;) {
+    ssize_t len = read(fd, buf, sizeof(buf));
+    if (len <= 0) {
+      break;
+    }
+    for (char* p = buf; p < buf + len;) {
+      const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+      p += sizeof(struct inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        qCritical() << "watch: event queue overflow, some files may not be converted";
+        continue;
+      }
+      if (event->len == 0) {
+        continue;
+      }
+      QString name = QFile::decodeName(event->name);
+      if (!name.endsWith(".ovl", Qt::CaseInsensitive)) {
+        continue;
+      }
+      changed.insert(watch_dir.filePath(name));
+      // restart the timer, the burst is converted once it is over
+      debounce.start();
+    }
+  }
+#endif
+}
+
+void
+DirectoryWatcher::schedule()
+{
+  for (auto&& path : std::as_const(changed)) {
+    if (running.contains(path)) {
+      rerun.insert(path);
+    } else if (!queue.contains(path)) {
+      queue.append(path);
+    }
+  }
+  changed.clear();
+  startJobs();
+}
+
+void
+DirectoryWatcher::startJobs()
+{
+  while (active < jobs && !queue.isEmpty()) {
+    const QString path = queue.takeFirst();
+    const QString outfile = out_dir.filePath(QFileInfo(path).completeBaseName() + suffix);
+    if (debuglevel > 0) {
+      qDebug() << "watch: converting" << path << "to" << outfile;
+    }
+
+    auto* process = new QProcess;
+    process->setProgram(QCoreApplication::applicationFilePath());
+    process->setArguments(arguments + QStringList{path, outfile});
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    // finished is overloaded in Qt5
+    QObject::connect(process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished), [this, process, path](int exitCode, QProcess::ExitStatus exitStatus) {
+      finishJob(process, path, exitStatus == QProcess::NormalExit && exitCode == 0);
+    });
+    QObject::connect(process, &QProcess::errorOccurred, [this, process, path](QProcess::ProcessError error) {
+      // finished is not emitted if the process could not be started
+      if (error == QProcess::FailedToStart) {
+        finishJob(process, path, false);
+      }
+    });
+    running.insert(path);
+    active++;
+    process->start();
+  }
+}
+
+void
+DirectoryWatcher::finishJob(QProcess* process, const QString& path, bool ok)
+{
+  if (!ok) {
+    qCritical() << "watch: conversion failed:" << path;
+  }
+  process->deleteLater();
+  running.remove(path);
+  active--;
+  if (rerun.remove(path)) {
+    queue.append(path);
+  }
+  startJobs();
+}
+
+int
+DirectoryWatcher::getDebugLevel()
+{
+  return debuglevel;
+}
+
+void
+DirectoryWatcher::setDebugLevel(int _debuglevel)
+{
+  debuglevel = _debuglevel;
+}
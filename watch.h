@@ -0,0 +1,82 @@
+/*
+
+    Watch a directory and convert new overlay files
+
+    Copyright (C) 2026 Ralf Horstmann <ralf@ackstorm.de>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#ifndef WATCH_H_INCLUDED_
+#define WATCH_H_INCLUDED_
+
+#include <QDir>
+#include <QProcess>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include <memory>
+
+// Converts .ovl files in a directory as soon as they have been
+// written (inotify close-write or moved into the directory). Events
+// are collected until the directory is quiet for a moment, then the
+// files are converted by at most jobs child processes running
+// ggvtogpx with the given arguments, so a broken file can not take
+// down the watcher.
+class DirectoryWatcher
+{
+public:
+  DirectoryWatcher(const QString& _watch_dir, const QString& _out_dir, const QString& _suffix,
+                   const QStringList& _arguments, int _jobs);
+  ~DirectoryWatcher();
+
+  DirectoryWatcher(const DirectoryWatcher&) = delete;
+  DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+  DirectoryWatcher(DirectoryWatcher&&) = delete;
+  DirectoryWatcher& operator=(DirectoryWatcher&&) = delete;
+
+  bool start();
+  int getDebugLevel();
+  void setDebugLevel(int _debuglevel);
+private:
+  void readEvents();
+  void schedule();
+  void startJobs();
+  void finishJob(QProcess* process, const QString& path, bool ok);
+
+  QDir watch_dir;
+  QDir out_dir;
+  QString suffix;
+  QStringList arguments;
+  int jobs;
+  int active;
+  int debuglevel;
+  int fd;
+  std::unique_ptr<QSocketNotifier> notifier;
+  QTimer debounce;
+  // changed files waiting for the directory to become quiet
+  QSet<QString> changed;
+  // files waiting for a free worker
+  QStringList queue;
+  QSet<QString> running;
+  // files that changed again while being converted
+  QSet<QString> rerun;
+};
+
+#endif